@@ -0,0 +1,85 @@
+#include "access_trace.hpp"
+
+#include <array>
+#include <cstring>
+
+namespace {
+
+constexpr std::array<char, 8> TRACE_MAGIC = {'B', 'M', 'T', 'R', 'A', 'C', 'E', '1'};
+constexpr uint64_t HEADER_SIZE = TRACE_MAGIC.size() + sizeof(uint64_t);
+
+void append_u64(std::vector<uint8_t> &buffer, uint64_t value) {
+    for (uint64_t byte = 0; byte < sizeof(value); ++byte) {
+        buffer.push_back(static_cast<uint8_t>(value >> (8 * byte)));
+    }
+}
+
+uint64_t load_u64(const uint8_t *data) {
+    uint64_t value = 0;
+    for (uint64_t byte = 0; byte < sizeof(value); ++byte) {
+        value |= uint64_t{data[byte]} << (8 * byte);
+    }
+    return value;
+}
+
+}  // namespace
+
+AccessTraceWriter::AccessTraceWriter(const std::filesystem::path &path)
+        : _file(path, std::ios::binary | std::ios::trunc) {
+    _buffer.reserve(BUFFER_SIZE);
+    _buffer.insert(_buffer.end(), TRACE_MAGIC.begin(), TRACE_MAGIC.end());
+    append_u64(_buffer, PAGE_SIZE);
+}
+
+AccessTraceWriter::~AccessTraceWriter() {
+    flush();
+}
+
+void AccessTraceWriter::record(TraceRecord record) {
+    std::lock_guard lock(_mutex);
+    append_u64(_buffer, record.page_id);
+    _buffer.push_back(static_cast<uint8_t>(record.operation) | static_cast<uint8_t>(record.state) << 4);
+    if (_buffer.size() + RECORD_SIZE > BUFFER_SIZE) {
+        _flush();
+    }
+}
+
+void AccessTraceWriter::flush() {
+    std::lock_guard lock(_mutex);
+    _flush();
+    _file.flush();
+}
+
+bool AccessTraceWriter::good() const {
+    std::lock_guard lock(_mutex);
+    return _file.good();
+}
+
+void AccessTraceWriter::_flush() {
+    _file.write(reinterpret_cast<const char *>(_buffer.data()), static_cast<std::streamsize>(_buffer.size()));
+    _buffer.clear();
+}
+
+bool read_trace(const std::filesystem::path &path, std::vector<TraceRecord> &records) {
+    std::ifstream file(path, std::ios::binary);
+    auto header = std::array<uint8_t, HEADER_SIZE>{};
+    if (!file.read(reinterpret_cast<char *>(header.data()), header.size()) ||
+        std::memcmp(header.data(), TRACE_MAGIC.data(), TRACE_MAGIC.size()) != 0 ||
+        load_u64(header.data() + TRACE_MAGIC.size()) != PAGE_SIZE) {
+        return false;
+    }
+
+    records.clear();
+    auto buffer = std::vector<uint8_t>(AccessTraceWriter::RECORD_SIZE * 4096);
+    while (file) {
+        file.read(reinterpret_cast<char *>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+        const auto record_count = static_cast<uint64_t>(file.gcount()) / AccessTraceWriter::RECORD_SIZE;
+        for (uint64_t index = 0; index < record_count; ++index) {
+            const auto *data = buffer.data() + index * AccessTraceWriter::RECORD_SIZE;
+            const auto flags = data[sizeof(PageID)];
+            records.push_back({load_u64(data), static_cast<TraceOperation>(flags & 0xf),
+                               static_cast<TraceState>(flags >> 4)});
+        }
+    }
+    return true;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <vector>
+
+#include "buffer_frame.hpp"
+
+// Page access traces of the buffer manager (see `BufferManager::start_trace`), e.g., to replay the accesses of a real
+// workload with other pool sizes or cooling shares (see test/trace_replay.cpp).
+//
+// A trace file starts with an 8 byte magic number and the page size (8 bytes). It is followed by one 9 byte record per
+// access: the page ID (8 bytes, little endian) and a byte holding the operation in the lower and the swip's state in
+// the upper four bits.
+
+// Operation of a trace record.
+enum class TraceOperation : uint8_t {
+  // `get_frame` or `get_frames` with `AccessMode::NORMAL`.
+  GET = 0,
+  // `get_frame` with `AccessMode::SCAN`.
+  SCAN = 1,
+  ALLOCATE = 2,
+  FREE = 3
+};
+
+// State of the accessed page's swip before the access. Allocations and frees record `HOT`.
+enum class TraceState : uint8_t { HOT = 0, COOLING = 1, EVICTED = 2 };
+
+struct TraceRecord {
+  PageID page_id;
+  TraceOperation operation;
+  TraceState state;
+};
+
+// Appends records to a trace file. Thread-safe: records of concurrent threads are appended in the order in which they
+// acquire the writer's lock. Records are buffered and written when the buffer is full, on `flush`, and on destruction.
+class AccessTraceWriter {
+ public:
+  static constexpr uint64_t RECORD_SIZE = 9;
+
+  // Creates the file at `path`, overwriting an existing file.
+  explicit AccessTraceWriter(const std::filesystem::path& path);
+
+  // Flushes the buffered records.
+  ~AccessTraceWriter();
+
+  void record(TraceRecord record);
+
+  // Writes the buffered records to the file.
+  void flush();
+
+  // Returns whether the file could be created and all writes succeeded.
+  bool good() const;
+
+  // Delete move and copy
+  AccessTraceWriter(const AccessTraceWriter&) = delete;
+  AccessTraceWriter(AccessTraceWriter&&) = delete;
+  AccessTraceWriter& operator=(const AccessTraceWriter&) = delete;
+  AccessTraceWriter& operator=(AccessTraceWriter&&) = delete;
+
+ private:
+  static constexpr uint64_t BUFFER_SIZE = 64 * KiB;
+
+  // Writes the buffered records. Expects `_mutex` to be held.
+  void _flush();
+
+  std::ofstream _file;
+  std::vector<uint8_t> _buffer;
+  mutable std::mutex _mutex;
+};
+
+// Reads all records of the trace file at `path`. Returns false if the file does not exist, is not a trace, or was
+// recorded with another page size. A truncated last record is ignored.
+bool read_trace(const std::filesystem::path& path, std::vector<TraceRecord>& records);
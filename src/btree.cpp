@@ -0,0 +1,387 @@
+#include "btree.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstring>
+
+namespace {
+
+using Key = BTree::Key;
+using Value = BTree::Value;
+
+// Level 0 denotes a leaf. A zeroed page is thus an empty leaf.
+struct NodeHeader {
+    uint32_t level;
+    uint32_t count;
+};
+
+struct LeafNode {
+    NodeHeader header;
+    Key keys[BTree::LEAF_CAPACITY];
+    Value values[BTree::LEAF_CAPACITY];
+};
+
+// Child i stores the keys in [keys[i - 1], keys[i]).
+struct InnerNode {
+    NodeHeader header;
+    Key keys[BTree::INNER_CAPACITY];
+    Swip children[BTree::INNER_CAPACITY + 1];
+};
+
+static_assert(sizeof(NodeHeader) == 8);
+static_assert(sizeof(LeafNode) <= EFFECTIVE_PAGE_SIZE && sizeof(InnerNode) <= EFFECTIVE_PAGE_SIZE);
+static_assert(ProvidesCallbacks<BTree>);
+
+NodeHeader &header(BufferFrame *frame) {
+    return *frame->as<NodeHeader>();
+}
+
+bool is_leaf(BufferFrame *frame) {
+    return header(frame).level == 0;
+}
+
+bool is_full(BufferFrame *frame) {
+    return header(frame).count == (is_leaf(frame) ? BTree::LEAF_CAPACITY : BTree::INNER_CAPACITY);
+}
+
+// Returns the index of the first key of the leaf that is not smaller than the key.
+uint64_t lower_bound(const LeafNode *node, Key key) {
+    return std::lower_bound(node->keys, node->keys + node->header.count, key) - node->keys;
+}
+
+// Returns the index of the child whose key range contains the key.
+uint64_t child_index(const InnerNode *node, Key key) {
+    return std::upper_bound(node->keys, node->keys + node->header.count, key) - node->keys;
+}
+
+void lock(BufferFrame *frame, bool exclusive) {
+    if (exclusive) {
+        frame->latch.lock();
+    } else {
+        frame->latch.lock_shared();
+    }
+}
+
+void unlock(BufferFrame *frame, bool exclusive) {
+    if (exclusive) {
+        frame->latch.unlock();
+    } else {
+        frame->latch.unlock_shared();
+    }
+}
+
+void set_parent(BufferFrame *frame, BufferFrame *parent) {
+    std::atomic_ref(frame->parent_frame).store(parent, std::memory_order_relaxed);
+}
+
+// Sets the parent frame of all children in memory. Only their frames point to the parent, evicted children are
+// loaded with the parent passed to `BufferManager::get_frame`.
+void set_parent_of_children(InnerNode *node, BufferFrame *parent, uint64_t begin, uint64_t end) {
+    for (auto index = begin; index < end; ++index) {
+        if (!node->children[index].is_evicted()) {
+            set_parent(node->children[index].buffer_frame_ignore_tags(), parent);
+        }
+    }
+}
+
+}  // namespace
+
+BTree::BTree(BufferManager &buffer_manager) : _buffer_manager(buffer_manager) {
+    _buffer_manager.register_static_callbacks(this);
+
+    auto *root = _buffer_manager.allocate_page_latched();
+    _root.swizzle(root);
+    root->mark_dirty();
+    root->latch.unlock();
+}
+
+bool BTree::insert(Key key, Value value) {
+    while (true) {
+        std::optional<Key> upper_fence;
+        auto *frame = _find_node(key, 0, true, upper_fence);
+        auto *leaf = frame->as<LeafNode>();
+        const auto index = lower_bound(leaf, key);
+        if (index < leaf->header.count && leaf->keys[index] == key) {
+            frame->latch.unlock();
+            return false;
+        }
+        if (is_full(frame)) {
+            frame->latch.unlock();
+            _split(key, 0);
+            continue;
+        }
+
+        const auto count = leaf->header.count;
+        std::memmove(leaf->keys + index + 1, leaf->keys + index, (count - index) * sizeof(Key));
+        std::memmove(leaf->values + index + 1, leaf->values + index, (count - index) * sizeof(Value));
+        leaf->keys[index] = key;
+        leaf->values[index] = value;
+        ++leaf->header.count;
+        frame->mark_dirty();
+        frame->latch.unlock();
+        return true;
+    }
+}
+
+std::optional<BTree::Value> BTree::lookup(Key key) {
+    std::optional<Key> upper_fence;
+    auto *frame = _find_node(key, 0, false, upper_fence);
+    auto *leaf = frame->as<LeafNode>();
+    const auto index = lower_bound(leaf, key);
+    std::optional<Value> value;
+    if (index < leaf->header.count && leaf->keys[index] == key) {
+        value = leaf->values[index];
+    }
+    frame->latch.unlock_shared();
+    return value;
+}
+
+bool BTree::remove(Key key) {
+    std::optional<Key> upper_fence;
+    auto *frame = _find_node(key, 0, true, upper_fence);
+    auto *leaf = frame->as<LeafNode>();
+    const auto index = lower_bound(leaf, key);
+    if (index == leaf->header.count || leaf->keys[index] != key) {
+        frame->latch.unlock();
+        return false;
+    }
+
+    const auto count = leaf->header.count;
+    std::memmove(leaf->keys + index, leaf->keys + index + 1, (count - index - 1) * sizeof(Key));
+    std::memmove(leaf->values + index, leaf->values + index + 1, (count - index - 1) * sizeof(Value));
+    --leaf->header.count;
+    frame->mark_dirty();
+    frame->latch.unlock();
+    return true;
+}
+
+void BTree::scan(Key begin, const ScanFunction &function) {
+    // Leaves do not reference their siblings, thus the scan descends again for the next leaf's key range.
+    std::optional<Key> key = begin;
+    while (key) {
+        std::optional<Key> upper_fence;
+        auto *frame = _find_node(*key, 0, false, upper_fence);
+        auto *leaf = frame->as<LeafNode>();
+        for (auto index = lower_bound(leaf, *key); index < leaf->header.count; ++index) {
+            if (!function(leaf->keys[index], leaf->values[index])) {
+                frame->latch.unlock_shared();
+                return;
+            }
+        }
+        frame->latch.unlock_shared();
+        key = upper_fence;
+    }
+}
+
+uint64_t BTree::height() {
+    auto *frame = _lock_root(false);
+    const auto height = header(frame).level + uint64_t{1};
+    frame->latch.unlock_shared();
+    return height;
+}
+
+Swip &BTree::get_parent(BufferFrame *frame, ManagedDataStructure *data_structure) {
+    auto *parent = std::atomic_ref(frame->parent_frame).load(std::memory_order_relaxed);
+    if (!parent) {
+        return static_cast<BTree *>(data_structure)->_root;
+    }
+    // The buffer manager holds the parent's latch, thus the swip cannot be moved concurrently.
+    auto *node = parent->as<InnerNode>();
+    uint64_t index = 0;
+    while (node->children[index].is_evicted() || node->children[index].buffer_frame_ignore_tags() != frame) {
+        ++index;
+        assert(index <= node->header.count);
+    }
+    return node->children[index];
+}
+
+Callbacks BTree::callbacks() {
+    return {[](BufferFrame *frame, Functor functor) { return iterate_children(frame, functor); }, get_parent};
+}
+
+std::span<Swip> BTree::_children(BufferFrame *frame) {
+    if (is_leaf(frame)) {
+        return {};
+    }
+    auto *node = frame->as<InnerNode>();
+    return {node->children, node->header.count + uint64_t{1}};
+}
+
+BufferFrame *BTree::_lock_root(bool exclusive) {
+    while (true) {
+        auto *frame = _buffer_manager.get_frame(_root);
+        lock(frame, exclusive);
+        // The root might have been evicted or replaced by a new root before we latched it. Once latched, it stays.
+        if (!_root.is_evicted() && _root.buffer_frame_ignore_tags() == frame) {
+            return frame;
+        }
+        unlock(frame, exclusive);
+    }
+}
+
+BufferFrame *BTree::_find_node(Key key, uint32_t level, bool exclusive, std::optional<Key> &upper_fence) {
+    while (true) {
+        upper_fence = std::nullopt;
+        auto *frame = _lock_root(false);
+        if (header(frame).level < level) {
+            frame->latch.unlock_shared();
+            return nullptr;
+        }
+        if (header(frame).level == level && exclusive) {
+            // Re-latch the root exclusively. It might have been split in the meantime.
+            frame->latch.unlock_shared();
+            frame = _lock_root(true);
+            if (header(frame).level == level) {
+                return frame;
+            }
+            frame->latch.unlock();
+            continue;
+        }
+
+        while (header(frame).level > level) {
+            auto *node = frame->as<InnerNode>();
+            const auto index = child_index(node, key);
+            if (index < node->header.count) {
+                upper_fence = node->keys[index];
+            }
+            auto *child = _lock_child(frame, index, exclusive && node->header.level == level + 1);
+            frame->latch.unlock_shared();
+            frame = child;
+        }
+        return frame;
+    }
+}
+
+BufferFrame *BTree::_lock_child(BufferFrame *parent, uint64_t index, bool exclusive) {
+    auto &swip = parent->as<InnerNode>()->children[index];
+    while (true) {
+        auto *child = _buffer_manager.get_frame(swip, AccessMode::NORMAL, parent);
+        lock(child, exclusive);
+        // Once latched, the child cannot be evicted anymore.
+        if (!swip.is_evicted() && swip.buffer_frame_ignore_tags() == child) {
+            return child;
+        }
+        unlock(child, exclusive);
+    }
+}
+
+void BTree::_split(Key key, uint32_t level) {
+    // Holding a node's latch exclusively keeps its children from being evicted, thus we allocate before latching.
+    auto *sibling = _buffer_manager.allocate_page_latched();
+    BufferFrame *new_root = nullptr;
+    while (true) {
+        std::optional<Key> upper_fence;
+        auto *parent = _find_node(key, level + 1, true, upper_fence);
+        if (!parent) {
+            // The node is the root.
+            auto *root = _lock_root(true);
+            if (header(root).level != level) {
+                // Another thread added a new root in the meantime.
+                root->latch.unlock();
+                continue;
+            }
+            if (is_full(root)) {
+                if (!new_root) {
+                    root->latch.unlock();
+                    new_root = _buffer_manager.allocate_page_latched();
+                    continue;
+                }
+                _split_root(root, new_root, sibling);
+                new_root = sibling = nullptr;
+            }
+            root->latch.unlock();
+            break;
+        }
+
+        if (is_full(parent)) {
+            parent->latch.unlock();
+            _split(key, level + 1);
+            continue;
+        }
+        auto *node = parent->as<InnerNode>();
+        const auto index = child_index(node, key);
+        if (node->children[index].is_evicted()) {
+            // Load the child without holding the parent's latch exclusively.
+            parent->latch.unlock();
+            if (auto *child = _find_node(key, level, false, upper_fence)) {
+                child->latch.unlock_shared();
+            }
+            continue;
+        }
+        auto *child = _buffer_manager.get_frame(node->children[index], AccessMode::NORMAL, parent);
+        child->latch.lock();
+        // Another thread might have split the node already.
+        if (is_full(child)) {
+            _split_child(parent, index, child, sibling);
+            sibling = nullptr;
+        }
+        child->latch.unlock();
+        parent->latch.unlock();
+        break;
+    }
+
+    // Free the frames we did not need.
+    for (auto *frame: {sibling, new_root}) {
+        if (frame) {
+            frame->latch.unlock();
+            _buffer_manager.free_page(frame);
+        }
+    }
+}
+
+void BTree::_split_child(BufferFrame *parent, uint64_t index, BufferFrame *child, BufferFrame *sibling) {
+    set_parent(sibling, parent);
+    header(sibling).level = header(child).level;
+
+    // Move the upper half of the child's entries to the new sibling, which becomes the child's right neighbor.
+    Key separator;
+    if (is_leaf(child)) {
+        auto *left = child->as<LeafNode>();
+        auto *right = sibling->as<LeafNode>();
+        const auto keep = left->header.count / 2;
+        const auto move = left->header.count - keep;
+        std::memcpy(right->keys, left->keys + keep, move * sizeof(Key));
+        std::memcpy(right->values, left->values + keep, move * sizeof(Value));
+        left->header.count = keep;
+        right->header.count = move;
+        separator = right->keys[0];
+    } else {
+        // The middle separator moves up to the parent.
+        auto *left = child->as<InnerNode>();
+        auto *right = sibling->as<InnerNode>();
+        const auto keep = left->header.count / 2;
+        const auto move = left->header.count - keep - 1;
+        separator = left->keys[keep];
+        std::memcpy(right->keys, left->keys + keep + 1, move * sizeof(Key));
+        std::memcpy(static_cast<void *>(right->children), left->children + keep + 1, (move + 1) * sizeof(Swip));
+        left->header.count = keep;
+        right->header.count = move;
+        set_parent_of_children(right, sibling, 0, move + 1);
+    }
+
+    auto *node = parent->as<InnerNode>();
+    const auto count = node->header.count;
+    std::memmove(node->keys + index + 1, node->keys + index, (count - index) * sizeof(Key));
+    std::memmove(static_cast<void *>(node->children + index + 2), node->children + index + 1,
+                 (count - index) * sizeof(Swip));
+    node->keys[index] = separator;
+    node->children[index + 1] = Swip(sibling);
+    ++node->header.count;
+
+    parent->mark_dirty();
+    child->mark_dirty();
+    sibling->mark_dirty();
+    sibling->latch.unlock();
+}
+
+void BTree::_split_root(BufferFrame *root, BufferFrame *new_root, BufferFrame *sibling) {
+    auto *node = new_root->as<InnerNode>();
+    node->header.level = header(root).level + 1;
+    node->children[0] = Swip(root);
+    set_parent(root, new_root);
+    _root.swizzle(new_root);
+
+    _split_child(new_root, 0, root, sibling);
+    new_root->latch.unlock();
+}
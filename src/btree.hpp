@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <span>
+
+#include "buffer_frame.hpp"
+#include "buffer_manager.hpp"
+#include "swip.hpp"
+
+// B+-tree with 8 byte keys and values whose nodes are pages of the buffer manager (see LeanStore, Section IV.). Inner
+// nodes reference their children via swips, so that traversing hot nodes does not need a page table lookup, and every
+// frame's `parent_frame` points to the frame of its parent node. The tree registers itself with the buffer manager, which
+// calls the tree's static callback functions (see `ProvidesCallbacks`), thus the buffer manager can manage only one tree
+// at a time.
+//
+// All operations are thread-safe. They descend with lock coupling: a node's latch is only released after its child is
+// latched. Inner nodes are latched in shared mode, leaves in the mode the operation needs. An insert into a full leaf
+// splits it and restarts. A split latches only the parent and the node exclusively, full parents are split first.
+// Frames for new nodes are allocated before latching, since allocating may have to evict children of the latched
+// nodes. Removing keys does not merge nodes.
+class BTree : public ManagedDataStructure {
+ public:
+  using Key = uint64_t;
+  using Value = uint64_t;
+
+  // Called for every entry of a range scan (see `scan`). Returns whether the scan continues.
+  using ScanFunction = std::function<bool(Key key, Value value)>;
+
+  // Creates an empty tree, i.e., a single empty leaf, and registers the tree with the buffer manager.
+  explicit BTree(BufferManager& buffer_manager);
+
+  // Inserts the key with the value. Returns false without modifying the tree if the key already exists.
+  bool insert(Key key, Value value);
+
+  // Returns the value of the key, or nullopt if the key does not exist.
+  std::optional<Value> lookup(Key key);
+
+  // Removes the key. Returns false if the key does not exist.
+  bool remove(Key key);
+
+  // Calls `function` for every entry with a key of at least `begin` in ascending key order, until the function returns
+  // false. The function is called while holding the latch of the entry's leaf, thus it must not access the tree.
+  void scan(Key begin, const ScanFunction& function);
+
+  // Returns the number of levels of the tree.
+  uint64_t height();
+
+  // Calls the functor for the swip of every child of the node until it returns true. Returns whether it returned true.
+  template <typename Function>
+  static bool iterate_children(BufferFrame* frame, Function&& functor) {
+    for (auto& swip : _children(frame)) {
+      if (functor(swip)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Returns the swip that references the node, i.e., its parent's child swip or the tree's root swip.
+  static Swip& get_parent(BufferFrame* frame, ManagedDataStructure* data_structure);
+
+  // Returns the callbacks of the tree as type-erased `Callbacks`, e.g., to compare them with the static callbacks that
+  // the tree registers.
+  static Callbacks callbacks();
+
+  // Maximum number of entries of a leaf and separators of an inner node. Nodes are pages of the smallest size class and
+  // start with an 8 byte header. An inner node stores one more child swip than separators.
+  static constexpr uint64_t LEAF_CAPACITY = (EFFECTIVE_PAGE_SIZE - 8) / (sizeof(Key) + sizeof(Value));
+  static constexpr uint64_t INNER_CAPACITY = (EFFECTIVE_PAGE_SIZE - 8 - sizeof(Swip)) / (sizeof(Key) + sizeof(Swip));
+
+  // Delete move and copy
+  BTree(const BTree&) = delete;
+  BTree(BTree&&) = delete;
+  BTree& operator=(const BTree&) = delete;
+  BTree& operator=(BTree&&) = delete;
+
+ private:
+  // Returns the child swips of the node, which are empty for a leaf.
+  static std::span<Swip> _children(BufferFrame* frame);
+
+  // Latches the frame of the root node and returns it.
+  BufferFrame* _lock_root(bool exclusive);
+
+  // Descends to the node at `level` whose key range contains the key and returns it latched. Nodes above are latched in
+  // shared mode, the returned node in shared or exclusive mode. `upper_fence` is set to the exclusive upper bound of the
+  // node's key range, or nullopt for the rightmost node. Returns nullptr if the tree has no node at `level`.
+  BufferFrame* _find_node(Key key, uint32_t level, bool exclusive, std::optional<Key>& upper_fence);
+
+  // Latches the child of the latched parent. The child might be evicted before we latch it, since the buffer manager
+  // only latches the parent in shared mode (see `GetParentFunction`), thus the swip is resolved again in that case.
+  BufferFrame* _lock_child(BufferFrame* parent, uint64_t index, bool exclusive);
+
+  // Splits the node at `level` whose key range contains the key if it is full. Full ancestors are split first.
+  void _split(Key key, uint32_t level);
+
+  // Moves the upper half of the full child at `index` of the parent into the new sibling and inserts the separator into
+  // the parent, which must have room for it. Expects all frames to be latched exclusively. Releases the sibling.
+  void _split_child(BufferFrame* parent, uint64_t index, BufferFrame* child, BufferFrame* sibling);
+
+  // Adds the new root above the full root and splits the old root into the sibling. Expects all frames to be latched
+  // exclusively. Releases the new root and the sibling.
+  void _split_root(BufferFrame* root, BufferFrame* new_root, BufferFrame* sibling);
+
+  BufferManager& _buffer_manager;
+
+  // Swip of the root node. The root's frame has no parent frame, thus the buffer manager unswizzles and evicts this
+  // swip (see `GetParentFunction`).
+  Swip _root;
+};
@@ -1,5 +1,7 @@
 #include "buffer_frame.hpp"
 
+#include <cstring>
+
 std::byte* Page::data() {
     return this->payload.data();
 }
@@ -7,13 +9,28 @@ std::byte* Page::data() {
 Page::operator std::byte*() { return reinterpret_cast<std::byte*>(this); }
 
 void BufferFrame::mark_dirty() {
-  dirty = true;
+  dirty.store(true);
 }
 
 void BufferFrame::mark_written_back() {
-  dirty = false;
+  dirty.store(false);
 }
 
 bool BufferFrame::is_dirty() {
-  return dirty;
+  return dirty.load();
+}
+
+void BufferFrame::reset() {
+  parent_frame = nullptr;
+  page_id = INVALID_PAGE_ID;
+  cooling_prev = nullptr;
+  cooling_next = nullptr;
+  cooling = false;
+  dirty.store(false, std::memory_order_relaxed);
+  loading.store(false, std::memory_order_relaxed);
+  std::memset(page.data(), 0, page_size());
+}
+
+uint64_t BufferFrame::page_size() const {
+  return ::page_size(size_class);
 }
@@ -1,26 +1,67 @@
 #pragma once
 
 #include <array>
+#include <atomic>
 #include <cstdint>
 #include <limits>
+#include <span>
+#include <type_traits>
+
+#include "config.hpp"
+#include "hybrid_latch.hpp"
 
 using PageID = uint64_t;
 static constexpr uint64_t KiB = 1024ul;
 static constexpr uint64_t MiB = 1024 * KiB;
 static constexpr uint64_t GiB = 1024 * MiB;
-static constexpr uint64_t PAGE_SIZE = 4 * KiB;
+static constexpr uint64_t PAGE_SIZE = BM_PAGE_SIZE;
+static constexpr uint64_t PAGE_ALIGNMENT = BM_PAGE_ALIGNMENT;
 // Data region to store the page's payload in. Note that other potential members of the page are also stored in a
 // page, which is the data unit that gets persisted. Thus, if you add further member variables, the payload is
 // smaller than PAGE_SIZE. In other words, the payload size is equal to: PAGE_SIZE - SIZE_OF_PAGE_MEMBERS.
 // TODO: check if I need to change this
 static constexpr uint64_t SIZE_OF_PAGE_MEMBERS = 0;
 
-// Note that we use the two least significant bits for tagging,
-static constexpr PageID MAX_PAGE_ID = (std::numeric_limits<PageID>::max() >> 2) - 1;
+// Note that we use the SWIP_TAG_BITS least significant bits for tagging (two by default),
+static constexpr uint64_t SWIP_TAG_BITS = BM_SWIP_TAG_BITS;
+static constexpr PageID MAX_PAGE_ID = (std::numeric_limits<PageID>::max() >> SWIP_TAG_BITS) - 1;
 static constexpr PageID INVALID_PAGE_ID = MAX_PAGE_ID + 1;
 
-// Need 512 Byte alignment for O_DIRECT.
-struct alignas(512) Page {
+// Pages come in size classes of PAGE_SIZE * 4^c bytes, so that a large node takes one frame and one I/O instead of a
+// chain of pages. On disk, a page of class c occupies 4^c consecutive PAGE_SIZE slots, aligned to its size. The names
+// of the size classes refer to the default page size.
+enum class PageSizeClass : uint8_t { SIZE_4K = 0, SIZE_16K = 1, SIZE_64K = 2, SIZE_256K = 3 };
+static constexpr uint64_t PAGE_SIZE_CLASS_COUNT = 4;
+
+// Like in Umbra, the size class is encoded in the page ID, so that a swip of an evicted page tells how large the page is.
+// The remaining bits store the page's first slot. Page IDs of the 4 KiB class are thus equal to their slot.
+static constexpr uint64_t PAGE_SIZE_CLASS_SHIFT = 62 - SWIP_TAG_BITS;
+static constexpr PageID PAGE_SLOT_MASK = (PageID{1} << PAGE_SIZE_CLASS_SHIFT) - 1;
+
+// Returns the number of PAGE_SIZE slots a page of the size class occupies.
+constexpr uint64_t page_slot_count(PageSizeClass size_class) {
+  return uint64_t{1} << (2 * static_cast<uint64_t>(size_class));
+}
+
+// Returns the size of the pages of the size class in bytes.
+constexpr uint64_t page_size(PageSizeClass size_class) {
+  return PAGE_SIZE * page_slot_count(size_class);
+}
+
+constexpr PageID make_page_id(PageID slot, PageSizeClass size_class) {
+  return (static_cast<PageID>(size_class) << PAGE_SIZE_CLASS_SHIFT) | slot;
+}
+
+constexpr PageSizeClass page_size_class(PageID page_id) {
+  return static_cast<PageSizeClass>(page_id >> PAGE_SIZE_CLASS_SHIFT);
+}
+
+constexpr PageID page_slot(PageID page_id) {
+  return page_id & PAGE_SLOT_MASK;
+}
+
+// Need 512 Byte alignment for O_DIRECT (see BM_PAGE_ALIGNMENT).
+struct alignas(PAGE_ALIGNMENT) Page {
   std::array<std::byte, PAGE_SIZE - SIZE_OF_PAGE_MEMBERS> payload{};
 
   // Utility function that returns the start address of the stored page's data.
@@ -33,9 +74,27 @@ struct alignas(512) Page {
 
 static constexpr uint64_t EFFECTIVE_PAGE_SIZE = sizeof(Page::payload);
 
-// Frames are physically interleaved with the page content. This should improve locality by reducing the number of cache
-// misses.
-struct BufferFrame {
+// Whether frames only store a reference to their page, which is stored in a separate arena (see BM_DECOUPLED_FRAMES).
+static constexpr bool DECOUPLED_FRAMES = BM_DECOUPLED_FRAMES;
+
+// Reference to a page of a decoupled frame. Provides the same accessors as `Page`, thus code accessing `frame->page`
+// works with both layouts. The volatile region sets the reference once, it does not change when the frame is reused.
+struct PageReference {
+  std::span<std::byte> payload{};
+
+  std::byte* data() { return payload.data(); }
+
+  operator std::byte*() { return payload.data(); }
+};
+
+// Interleaved frames are aligned like their page. Decoupled frames are aligned to a cache line, so that the metadata of
+// a frame never shares a cache line with another frame's.
+static constexpr uint64_t FRAME_ALIGNMENT = DECOUPLED_FRAMES ? 64 : PAGE_ALIGNMENT;
+
+// By default, frames are physically interleaved with the page content. This should improve locality by reducing the
+// number of cache misses when a page is accessed through its frame. With BM_DECOUPLED_FRAMES, the frame only holds the
+// metadata and a reference to the page.
+struct alignas(FRAME_ALIGNMENT) BufferFrame {
   BufferFrame() = default;
   // Sets a marker indicating that the corresponding page is dirty / modified. This is relevant for evicting a page:
   // only dirty pages need to be flushed to disk.
@@ -47,6 +106,11 @@ struct BufferFrame {
   // Checks whether the corresponding page is dirty / modified.
   bool is_dirty();
 
+  // Resets the frame to its initial state so that it can be reused for another page. In contrast to re-constructing
+  // the frame, the latch (and thus its version) is kept, so that optimistic readers of the previous page fail their
+  // validation instead of observing a recycled version.
+  void reset();
+
   // Utility function to cast the stored page's data to a T pointer. If you store an object of type T in a page, you can
   // use `frame_pointer->as<T>()` to get the data stored in the page's payload as a T pointer (T*).
   template <typename T>
@@ -54,15 +118,40 @@ struct BufferFrame {
     return reinterpret_cast<T*>(page.data());
   }
 
-  // Parent pointer is relevant if data needs to be unswizzled. This is managed by a buffer managed data structure.
-  // You do not need to modify it.
+  // Parent pointer is relevant if data needs to be unswizzled. This is managed by a buffer managed data structure (see
+  // `GetParentFunction`) and set by `BufferManager::get_frame` when a page is loaded. Since the buffer manager reads it
+  // without holding the parent's latch, it is accessed via std::atomic_ref.
   BufferFrame* parent_frame = nullptr;
 
   // Page ID of the corresponding page.
   PageID page_id = INVALID_PAGE_ID;
 
-  // Actual page data.
-  Page page{};
+  // Protects the frame's page. Readers of a swizzled page can use the optimistic mode and validate the version instead
+  // of writing to the frame. The buffer manager only evicts a frame while holding this latch exclusively.
+  HybridLatch latch;
+
+  // Links of the intrusive cooling queue (see `CoolingQueue`). Only valid if `cooling` is set. Protected by the buffer
+  // manager.
+  BufferFrame* cooling_prev = nullptr;
+  BufferFrame* cooling_next = nullptr;
+  bool cooling = false;
+
+  // Atomic, since evicting a child page marks its parent dirty while other threads hold the parent's latch in shared
+  // mode (see `GetParentFunction`).
+  std::atomic<bool> dirty = false;
+
+  // Set while the page is read into the frame in the background (see `BufferManager::prefetch`). The frame is already
+  // referenced by a swizzled swip, thus `BufferManager::get_frame` waits until the flag is cleared.
+  std::atomic<bool> loading = false;
+
+  // Size class of the frame, which is fixed by the volatile region. Frames of larger size classes store the rest of
+  // their page directly behind the frame.
+  PageSizeClass size_class = PageSizeClass::SIZE_4K;
+
+  // Returns the size of the frame's page in bytes.
+  uint64_t page_size() const;
 
-  bool dirty = false;
+  // Actual page data. Must stay the last member, since pages of larger size classes extend beyond the frame. Decoupled
+  // frames reference their page instead.
+  std::conditional_t<DECOUPLED_FRAMES, PageReference, Page> page{};
 };
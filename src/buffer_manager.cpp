@@ -1,16 +1,53 @@
 #include "buffer_manager.hpp"
 
-#include <iterator>
+#include <algorithm>
+#include <array>
 #include <memory>
+#include <thread>
+#include <vector>
 
 #include "buffer_frame.hpp"
 #include "swip.hpp"
 
-BufferManager::BufferManager(std::unique_ptr<VolatileRegion> volatile_region, std::unique_ptr<SSDRegion> ssd_region)
+const BufferManager::CallbackDispatch BufferManager::TYPE_ERASED_CALLBACK_DISPATCH = {
+        [](const Callbacks &callbacks, BufferFrame *frame) -> BufferFrame * {
+            if (!callbacks.iterate_children) {
+                return nullptr;
+            }
+            BufferFrame *child = nullptr;
+            callbacks.iterate_children(frame, [&child](Swip &swip) {
+                if (swip.is_swizzled()) {
+                    child = swip.buffer_frame();
+                    return true;
+                }
+                return false;
+            });
+            return child;
+        },
+        [](const Callbacks &callbacks, BufferFrame *frame) {
+            return callbacks.iterate_children &&
+                   callbacks.iterate_children(frame, [](Swip &swip) { return !swip.is_evicted(); });
+        },
+        [](const Callbacks &callbacks, BufferFrame *frame, ManagedDataStructure *data_structure) -> Swip * {
+            return callbacks.get_parent ? &callbacks.get_parent(frame, data_structure) : nullptr;
+        }};
+
+BufferManager::BufferManager(std::unique_ptr<VolatileRegion> volatile_region, std::unique_ptr<SSDRegion> ssd_region,
+                             CoolingStageConfig cooling_stage_config)
         : _volatile_region(std::move(volatile_region)), _ssd_region(std::move(ssd_region)),
+          _cooling_partitions(_volatile_region->partition_count()),
           FRAME_COUNT_MAX(_volatile_region->frame_count()),
-          FRAMES_NEEDED_IN_COOLING_STAGE(static_cast<uint64_t>(FRAME_COUNT_MAX * SHARE_COOLING_PAGES)),
-          FIFTY_PERCENT_FRAMES(static_cast<uint64_t>(FRAME_COUNT_MAX * SHARE_USED_PAGES_BEFORE_COOLING)) {
+          FRAMES_NEEDED_IN_COOLING_STAGE(
+                  static_cast<uint64_t>(FRAME_COUNT_MAX * cooling_stage_config.share_cooling_pages)),
+          FIFTY_PERCENT_FRAMES(
+                  static_cast<uint64_t>(FRAME_COUNT_MAX * cooling_stage_config.share_used_pages_before_cooling)),
+          _cooling_stage_config(cooling_stage_config),
+          _cooling_target(FRAMES_NEEDED_IN_COOLING_STAGE),
+          _min_cooling_target(std::max<uint64_t>(
+                  static_cast<uint64_t>(FRAME_COUNT_MAX * cooling_stage_config.min_share_cooling_pages), 1)),
+          _max_cooling_target(std::max(
+                  static_cast<uint64_t>(FRAME_COUNT_MAX * cooling_stage_config.max_share_cooling_pages),
+                  _min_cooling_target)) {
     // Do not modify the lines below.
     _random_generator.seed(42);
     _distribution = std::uniform_int_distribution<uint64_t>(0, _volatile_region->frame_count() - 1);
@@ -18,19 +55,45 @@ BufferManager::BufferManager(std::unique_ptr<VolatileRegion> volatile_region, st
     // ...
 }
 
-BufferFrame *BufferManager::allocate_page() {
-    if (_volatile_region->free_frame_count() == 0) {
-        _evict_page();
+BufferManager::~BufferManager() {
+    stop_background_writer();
+    stop_page_provider();
+    {
+        std::lock_guard lock(_prefetch_mutex);
+        if (!_prefetcher_running) {
+            return;
+        }
+        _prefetcher_running = false;
     }
+    _prefetch_wakeup.notify_one();
+    _prefetcher.join();
+}
 
-    auto *bf = _volatile_region->allocate_frame();
-    auto pageId = _ssd_region->allocate_page_id();
+BufferFrame *BufferManager::allocate_page(PageSizeClass size_class) {
+    auto *bf = allocate_page_latched(size_class);
+    bf->latch.unlock();
+    return bf;
+}
+
+BufferFrame *BufferManager::allocate_page_latched(PageSizeClass size_class) {
+    auto *bf = _allocate_frame(size_class);
+    bf->latch.lock();
+    auto pageId = _ssd_region->allocate_page_id(size_class);
     bf->page_id = pageId;
+    if (_trace) [[unlikely]] {
+        _trace->record({pageId, TraceOperation::ALLOCATE, TraceState::HOT});
+    }
     _create_cooling_state_share(bf);
+    _notify_page_provider();
     return bf;
 }
 
 void BufferManager::free_page(BufferFrame *frame) {
+    if (_trace) [[unlikely]] {
+        _trace->record({frame->page_id, TraceOperation::FREE, TraceState::HOT});
+    }
+    // A freed frame must not be evicted later on.
+    _remove_eviction_candidate(frame);
     // use this order because otherwise the page_id is INVALID
     // in the volatile region we directly overwrite at the frame memory addresss
     // thus when reading from it again we get not the correct page id back
@@ -38,104 +101,635 @@ void BufferManager::free_page(BufferFrame *frame) {
     _volatile_region->free_frame(frame);
 }
 
-BufferFrame *BufferManager::get_frame(Swip &swip) {
-    // Resolve swizzled Swip
-    if (swip.is_swizzled()) {
-        return swip.buffer_frame();
+BufferFrame *BufferManager::get_frame(Swip &swip, AccessMode mode, BufferFrame *parent) {
+    if (_trace) [[unlikely]] {
+        _trace_access(swip, mode);
     }
+    // Every state is re-checked after taking the corresponding lock, another thread might have changed it meanwhile.
+    while (true) {
+        // Resolve swizzled Swip. This is the hot path: it neither takes a lock nor writes to a shared cache line.
+        if (swip.is_swizzled()) {
+            auto *bf = swip.buffer_frame();
+            _statistics.add(Counter::HITS);
+            _wait_for_load(bf);
+            return bf;
+        }
 
         // Resolve cooling Swip
-    else if (swip.is_cooling()) {
-        swip.swizzle();
-        _remove_eviction_candidate(swip.buffer_frame());
-        _create_cooling_state_share(swip.buffer_frame());
-        return swip.buffer_frame();
-    }
+        else if (swip.is_cooling()) {
+            if (mode == AccessMode::SCAN) {
+                // Keep the page cooling, its swip has to be resolved again by the next access anyway.
+                auto *bf = swip.buffer_frame_ignore_tags();
+                if (!_volatile_region->address_in_range(bf)) {
+                    continue;
+                }
+                auto &partition = _cooling_partition(bf);
+                std::lock_guard lock(partition.mutex);
+                if (!swip.is_cooling() || swip.buffer_frame_ignore_tags() != bf) {
+                    continue;
+                }
+                _statistics.add(Counter::HITS);
+                return bf;
+            }
+            if (auto *bf = _swizzle_cooling(swip)) {
+                _create_cooling_state_share(bf);
+                return bf;
+            }
+            continue;
+        }
+
         // Resolve evicted Swip
-    else {
-        if (_volatile_region->free_frame_count() == 0) {
-            _evict_page();
+        const auto start = StatisticsCollector::start();
+        if (auto *bf = _load_page(swip, parent)) {
+            _statistics.add(Counter::MISSES);
+            if (mode == AccessMode::SCAN) {
+                // Scan pages replace each other in the cooling stage, thus there is no need to sample hot pages.
+                _add_scan_frame(bf, swip);
+            } else {
+                // Ensure the number of cooling frames since the allocation might have triggered an eviction.
+                _create_cooling_state_share(bf);
+            }
+            _notify_page_provider();
+            _statistics.record(Latency::MISS, start);
+            return bf;
+        }
+    }
+}
+
+void BufferManager::prefetch(Swip &swip) {
+    prefetch(std::span<Swip>(&swip, 1));
+}
+
+void BufferManager::prefetch(std::span<Swip> swips) {
+    auto frames = std::vector<BufferFrame *>{};
+    for (auto &swip: swips) {
+        if (!swip.is_evicted()) {
+            continue;
+        }
+        if (auto *bf = _reserve_frame(swip)) {
+            frames.push_back(bf);
+        }
+    }
+    if (frames.empty()) {
+        return;
+    }
+    _create_cooling_state_share(nullptr);
+    _notify_page_provider();
+
+    {
+        std::lock_guard lock(_prefetch_mutex);
+        _prefetch_queue.insert(_prefetch_queue.end(), frames.begin(), frames.end());
+        if (!_prefetcher_running) {
+            _prefetcher_running = true;
+            _prefetcher = std::thread(&BufferManager::_run_prefetcher, this);
         }
+    }
+    _prefetch_wakeup.notify_one();
+}
+
+void BufferManager::get_frames(std::span<Swip *const> swips, std::span<BufferFrame *> frames) {
+    // Classify all swips in one pass. Misses get a frame reserved right away and are read with a single batch.
+    auto loads = std::vector<BufferFrame *>{};
+    for (uint64_t index = 0; index < swips.size(); ++index) {
+        auto &swip = *swips[index];
+        if (_trace) [[unlikely]] {
+            _trace_access(swip, AccessMode::NORMAL);
+        }
+        while (true) {
+            if (swip.is_swizzled()) {
+                // The frame might still be loaded by another thread, we wait for it below.
+                frames[index] = swip.buffer_frame();
+                _statistics.add(Counter::HITS);
+                break;
+            } else if (swip.is_cooling()) {
+                if (auto *bf = _swizzle_cooling(swip)) {
+                    frames[index] = bf;
+                    break;
+                }
+            } else if (auto *bf = _reserve_frame(swip)) {
+                frames[index] = bf;
+                loads.push_back(bf);
+                _statistics.add(Counter::MISSES);
+                break;
+            }
+        }
+    }
 
-        auto *bf = _volatile_region->allocate_frame();
-        _create_cooling_state_share(bf);
+    if (!loads.empty()) {
+        // Ensure the number of cooling frames since the allocations might have triggered evictions.
+        _create_cooling_state_share(nullptr);
+        _notify_page_provider();
+        _load_pages(loads);
+    }
+    for (auto *bf: frames.first(swips.size())) {
+        _wait_for_load(bf);
+    }
+}
+
+void BufferManager::sync() {
+    _ssd_region->sync();
+}
+
+void BufferManager::start_page_provider(PageProviderConfig config) {
+    std::lock_guard lock(_page_provider_mutex);
+    if (_page_provider_running) {
+        return;
+    }
+    _page_provider_config = config;
+    _page_provider_running = true;
+    _page_provider = std::thread(&BufferManager::_run_page_provider, this);
+}
+
+void BufferManager::stop_page_provider() {
+    {
+        std::lock_guard lock(_page_provider_mutex);
+        if (!_page_provider_running) {
+            return;
+        }
+        _page_provider_running = false;
+    }
+    _page_provider_wakeup.notify_one();
+    _page_provider.join();
+}
 
-        auto pageId = swip.page_id();
-        bf->page_id = pageId;
-        swip.swizzle(bf);
-        _ssd_region->read_page(bf->page.data(), pageId);
+void BufferManager::start_background_writer(BackgroundWriterConfig config) {
+    std::lock_guard lock(_background_writer_mutex);
+    if (_background_writer_running) {
+        return;
+    }
+    _background_writer_config = config;
+    _background_writer_running = true;
+    _background_writer = std::thread(&BufferManager::_run_background_writer, this);
+}
 
-        return bf;
+void BufferManager::stop_background_writer() {
+    {
+        std::lock_guard lock(_background_writer_mutex);
+        if (!_background_writer_running) {
+            return;
+        }
+        _background_writer_running = false;
     }
-    // Ensure the number of cooling frames if a frame was allocated in this function since this allocation might have
-    // triggered an eviction.
+    _background_writer_wakeup.notify_one();
+    _background_writer.join();
 }
 
-void BufferManager::register_callbacks(Callbacks &&callbacks) { _callbacks = std::move(callbacks); }
+Statistics BufferManager::statistics() const {
+    auto statistics = _statistics.collect();
+    statistics.cooling_target = cooling_target();
+    return statistics;
+}
+
+uint64_t BufferManager::cooling_target() const {
+    return _cooling_target.load(std::memory_order_relaxed);
+}
+
+void BufferManager::start_trace(const std::filesystem::path &path) {
+    _trace = std::make_unique<AccessTraceWriter>(path);
+}
+
+void BufferManager::stop_trace() {
+    _trace.reset();
+}
+
+void BufferManager::register_callbacks(Callbacks &&callbacks) {
+    _callbacks = std::move(callbacks);
+    _callback_dispatch = &TYPE_ERASED_CALLBACK_DISPATCH;
+}
 
 void BufferManager::register_data_structure(ManagedDataStructure *data_structure) {
     _managed_data_structure = data_structure;
 }
 
 void BufferManager::_flush(BufferFrame *frame) {
+    const auto start = StatisticsCollector::start();
     _ssd_region->write_page(frame->page.data(), frame->page_id);
+    _record_io(true, std::array{PageIO{frame->page.data(), frame->page_id}}, start);
     frame->mark_written_back();
 }
 
-void BufferManager::_evict_page() {
+bool BufferManager::_evict_page() {
+    return _evict_candidate(std::nullopt);
+}
+
+bool BufferManager::_evict_candidate(std::optional<PageSizeClass> size_class) {
     // Flush the page if dirty. Set the page id for the swip pointing to the page. Free the frame.
-    auto *bf = _pop_eviction_candidate();
-    if (bf->is_dirty()) {
-        _flush(bf);
-    }
+    // Candidates that are currently latched by another thread are skipped and moved to the end of their partition.
+    const auto home = _volatile_region->home_partition();
+    for (uint64_t offset = 0; offset < _cooling_partitions.size(); ++offset) {
+        auto &partition = _cooling_partitions[(home + offset) % _cooling_partitions.size()];
+        std::lock_guard lock(partition.mutex);
+        auto *bf = partition.queue.front();
+        for (auto attempts = partition.queue.size(); bf && attempts > 0; --attempts) {
+            auto *next = bf->cooling_next;
+            if (size_class && bf->size_class != *size_class) {
+                bf = next;
+                continue;
+            }
+            partition.queue.remove(bf);
+            if (!bf->latch.try_lock()) {
+                partition.queue.push_back(bf);
+                bf = next;
+                continue;
+            }
+            // A page whose children are still in memory stores their frame addresses, thus it cannot be written back.
+            if (_has_resident_children(bf)) {
+                bf->latch.unlock();
+                partition.queue.push_back(bf);
+                bf = next;
+                continue;
+            }
 
-    if (_callbacks.get_parent) {
-        _callbacks.get_parent(bf, _managed_data_structure).evict(bf->page_id);
-    }
+            if (bf->is_dirty()) {
+                _statistics.add(Counter::EVICTION_FLUSHES);
+                // Write further dirty candidates along, adjacent pages are then written with a single call.
+                auto frames = std::vector<BufferFrame *>{bf};
+                _collect_dirty_candidates(partition, EVICTION_WRITE_BATCH_SIZE, frames);
+                _write_back(frames);
+                for (auto *frame: std::span(frames).subspan(1)) {
+                    frame->latch.unlock_shared();
+                }
+            }
+
+            // Evicting the page changes the swip stored in the parent's page.
+            if (!_try_lock_parent(bf)) {
+                bf->latch.unlock();
+                partition.queue.push_back(bf);
+                bf = next;
+                continue;
+            }
+            _cooling_count.fetch_sub(1, std::memory_order_relaxed);
+
+            if (auto *swip = _callback_dispatch->parent_swip(_callbacks, bf, _managed_data_structure)) {
+                swip->evict(bf->page_id);
+            }
+            if (auto *parent = std::atomic_ref(bf->parent_frame).load(std::memory_order_relaxed)) {
+                parent->mark_dirty();
+            }
+            _unlock_parent(bf);
 
-    _volatile_region->free_frame(bf);
+            _volatile_region->free_frame(bf);
+            bf->latch.unlock();
+            _statistics.add(Counter::EVICTIONS);
+            if (_cooling_stage_config.adaptive) {
+                _evicted_since_adaptation.fetch_add(1, std::memory_order_relaxed);
+            }
+            return true;
+        }
+    }
+    return false;
 }
 
 bool BufferManager::_has_eviction_candidate(BufferFrame *frame) {
-    return fast_access.contains(frame);
+    return CoolingQueue::contains(frame);
 }
 
 BufferFrame *BufferManager::_pop_eviction_candidate() {
-    auto begin = eviction_list.begin();
-    fast_access.erase(*begin);
-    eviction_list.erase(begin);
-    return *begin;
+    const auto home = _volatile_region->home_partition();
+    for (uint64_t offset = 0; offset < _cooling_partitions.size(); ++offset) {
+        auto &partition = _cooling_partitions[(home + offset) % _cooling_partitions.size()];
+        std::lock_guard lock(partition.mutex);
+        if (auto *frame = partition.queue.pop_front()) {
+            _cooling_count.fetch_sub(1, std::memory_order_relaxed);
+            _volatile_region->set_cooling(frame, false);
+            return frame;
+        }
+    }
+    return nullptr;
 }
 
-void BufferManager::_add_eviction_candidate(BufferFrame *frame) {
-    if (!_has_eviction_candidate(frame)) {
+bool BufferManager::_add_eviction_candidate(BufferFrame *frame) {
+    auto &partition = _cooling_partition(frame);
+    std::lock_guard lock(partition.mutex);
+    // Shared mode suffices to exclude loading and evicting threads, and it does not invalidate optimistic readers.
+    if (_has_eviction_candidate(frame) || !frame->latch.try_lock_shared()) {
+        return false;
+    }
+    // Frames that are being prefetched must not be evicted before their page is loaded.
+    if (frame->page_id == INVALID_PAGE_ID || frame->loading.load(std::memory_order_acquire) ||
+        !_try_lock_parent(frame)) {
+        frame->latch.unlock_shared();
+        return false;
+    }
 
-        fast_access[frame] = eviction_list.insert(eviction_list.end(), frame);
+    partition.queue.push_back(frame);
+    _cooling_count.fetch_add(1, std::memory_order_relaxed);
+    _volatile_region->set_cooling(frame, true);
+    _statistics.add(Counter::PAGES_COOLED);
 
-        if (_callbacks.get_parent) {
-            _callbacks.get_parent(frame, _managed_data_structure).unswizzle();
-        }
+    if (auto *swip = _callback_dispatch->parent_swip(_callbacks, frame, _managed_data_structure)) {
+        swip->unswizzle();
     }
+    _unlock_parent(frame);
+    frame->latch.unlock_shared();
+    return true;
 }
 
 void BufferManager::_remove_eviction_candidate(BufferFrame *frame) {
-    if (auto element = fast_access.find(frame); element != fast_access.end()) {
-        eviction_list.erase(element->second);
-        fast_access.erase(element->first);
+    auto &partition = _cooling_partition(frame);
+    std::lock_guard lock(partition.mutex);
+    if (_has_eviction_candidate(frame)) {
+        partition.queue.remove(frame);
+        _cooling_count.fetch_sub(1, std::memory_order_relaxed);
+        _volatile_region->set_cooling(frame, false);
     }
 }
 
 uint32_t BufferManager::_eviction_candidate_count() {
-    return eviction_list.size();
+    return _cooling_count.load(std::memory_order_relaxed);
+}
+
+uint64_t BufferManager::_write_back_eviction_candidates(uint64_t max_count) {
+    // The shared latches keep the frames from being evicted and their pages from being modified while they are written.
+    // Thus, we do not have to hold the partition locks during the write.
+    auto frames = std::vector<BufferFrame *>{};
+    for (auto &partition: _cooling_partitions) {
+        std::lock_guard lock(partition.mutex);
+        _collect_dirty_candidates(partition, max_count, frames);
+    }
+    _write_back(frames);
+    for (auto *frame: frames) {
+        frame->latch.unlock_shared();
+    }
+    return frames.size();
+}
+
+BufferManager::CoolingPartition &BufferManager::_cooling_partition(const BufferFrame *frame) {
+    return _cooling_partitions[_volatile_region->partition_of(frame)];
+}
+
+BufferFrame *BufferManager::_allocate_frame(PageSizeClass size_class) {
+    while (true) {
+        if (auto *bf = _volatile_region->allocate_frame(size_class)) {
+            return bf;
+        }
+        // Another thread might take the evicted frame before we do, thus we retry.
+        if (_evict_candidate(size_class)) {
+            continue;
+        }
+        // No frame of the size class is cooling (or all of them are latched), e.g., because the cooling stage is filled
+        // with frames of other size classes.
+        if (!_cool_frame_of_size_class(size_class)) {
+            _wait_for_eviction_progress();
+        }
+    }
+}
+
+BufferFrame *BufferManager::_load_page(Swip &swip, BufferFrame *parent) {
+    const auto pageId = swip.page_id();
+    std::lock_guard lock(_page_locks[pageId % PAGE_LOCK_COUNT]);
+    if (!swip.is_evicted() || swip.page_id() != pageId) {
+        return nullptr;
+    }
+
+    auto *bf = _allocate_frame(page_size_class(pageId));
+    // Load the page before publishing the frame via the swip. Stale readers that still hold a pointer to this frame
+    // from a previous page detect the change through the latch's version.
+    bf->latch.lock();
+    bf->page_id = pageId;
+    std::atomic_ref(bf->parent_frame).store(parent, std::memory_order_relaxed);
+    const auto start = StatisticsCollector::start();
+    _ssd_region->read_page(bf->page.data(), pageId);
+    _record_io(false, std::array{PageIO{bf->page.data(), pageId}}, start);
+    swip.swizzle(bf);
+    bf->latch.unlock();
+    return bf;
+}
+
+bool BufferManager::_try_lock_parent(BufferFrame *frame) {
+    auto *parent = std::atomic_ref(frame->parent_frame).load(std::memory_order_relaxed);
+    if (!parent) {
+        return true;
+    }
+    if (!parent->latch.try_lock_shared()) {
+        return false;
+    }
+    // The data structure might have moved the swip to another parent before we latched this one.
+    if (std::atomic_ref(frame->parent_frame).load(std::memory_order_relaxed) != parent) {
+        parent->latch.unlock_shared();
+        return false;
+    }
+    return true;
+}
+
+void BufferManager::_unlock_parent(BufferFrame *frame) {
+    // The parent cannot change while it is latched.
+    if (auto *parent = std::atomic_ref(frame->parent_frame).load(std::memory_order_relaxed)) {
+        parent->latch.unlock_shared();
+    }
+}
+
+bool BufferManager::_has_resident_children(BufferFrame *frame) {
+    return _callback_dispatch->has_resident_children(_callbacks, frame);
+}
+
+void BufferManager::_wait_for_eviction_progress() {
+    // All eviction candidates are latched by other threads. Give them a chance to make progress.
+    std::this_thread::yield();
+}
+
+void BufferManager::_notify_page_provider() {
+    if (_page_provider_running &&
+        _volatile_region->free_frame_count() < _page_provider_config.free_frames_target) {
+        _page_provider_wakeup.notify_one();
+    }
+}
+
+void BufferManager::_run_page_provider() {
+    std::unique_lock lock(_page_provider_mutex);
+    while (_page_provider_running) {
+        if (_volatile_region->free_frame_count() < _page_provider_config.free_frames_target) {
+            lock.unlock();
+            // Keep the cooling stage filled, so that foreground threads do not have to sample.
+            _create_cooling_state_share(nullptr);
+            const bool evicted = _evict_page();
+            lock.lock();
+            if (evicted) {
+                continue;
+            }
+        }
+        _page_provider_wakeup.wait_for(lock, _page_provider_config.interval);
+    }
+}
+
+void BufferManager::_collect_dirty_candidates(CoolingPartition &partition, uint64_t max_count,
+                                              std::vector<BufferFrame *> &frames) {
+    for (auto *bf = partition.queue.front(); bf && frames.size() < max_count; bf = bf->cooling_next) {
+        if (!bf->latch.try_lock_shared()) {
+            continue;
+        }
+        if (!bf->is_dirty()) {
+            bf->latch.unlock_shared();
+            continue;
+        }
+        frames.push_back(bf);
+    }
+}
+
+void BufferManager::_write_back(std::span<BufferFrame *const> frames) {
+    if (frames.empty()) {
+        return;
+    }
+    auto requests = std::vector<PageIO>{};
+    requests.reserve(frames.size());
+    for (auto *frame: frames) {
+        frame->mark_written_back();
+        requests.push_back({frame->page.data(), frame->page_id});
+    }
+    const auto start = StatisticsCollector::start();
+    _ssd_region->write_pages(requests);
+    _record_io(true, requests, start);
+}
+
+void BufferManager::_run_background_writer() {
+    std::unique_lock lock(_background_writer_mutex);
+    while (_background_writer_running) {
+        const auto batch_size = _background_writer_config.batch_size;
+        lock.unlock();
+        const auto written = _write_back_eviction_candidates(batch_size);
+        lock.lock();
+        // A full batch indicates that more dirty candidates are waiting.
+        if (written < batch_size) {
+            _background_writer_wakeup.wait_for(lock, _background_writer_config.interval);
+        }
+    }
+}
+
+void BufferManager::_add_scan_frame(BufferFrame *frame, Swip &swip) {
+    auto &partition = _cooling_partition(frame);
+    std::lock_guard lock(partition.mutex);
+    if (_has_eviction_candidate(frame) || !frame->latch.try_lock_shared()) {
+        return;
+    }
+    if (!_try_lock_parent(frame)) {
+        frame->latch.unlock_shared();
+        return;
+    }
+    // Another thread might have evicted and reused the frame already.
+    if (swip.is_swizzled() && swip.buffer_frame() == frame) {
+        partition.queue.push_back(frame);
+        _cooling_count.fetch_add(1, std::memory_order_relaxed);
+        _volatile_region->set_cooling(frame, true);
+        _statistics.add(Counter::PAGES_COOLED);
+        swip.unswizzle();
+    }
+    _unlock_parent(frame);
+    frame->latch.unlock_shared();
+}
+
+BufferFrame *BufferManager::_swizzle_cooling(Swip &swip) {
+    auto *bf = swip.buffer_frame_ignore_tags();
+    // The swip might have been evicted after checking its state, then it does not store a frame.
+    if (!_volatile_region->address_in_range(bf)) {
+        return nullptr;
+    }
+    auto &partition = _cooling_partition(bf);
+    std::lock_guard lock(partition.mutex);
+    if (!swip.is_cooling() || swip.buffer_frame_ignore_tags() != bf) {
+        return nullptr;
+    }
+    swip.swizzle();
+    if (_has_eviction_candidate(bf)) {
+        partition.queue.remove(bf);
+        _cooling_count.fetch_sub(1, std::memory_order_relaxed);
+        _volatile_region->set_cooling(bf, false);
+    }
+    _statistics.add(Counter::COOLING_RESCUES);
+    if (_cooling_stage_config.adaptive) {
+        _rescued_since_adaptation.fetch_add(1, std::memory_order_relaxed);
+    }
+    return bf;
+}
+
+BufferFrame *BufferManager::_reserve_frame(Swip &swip) {
+    const auto pageId = swip.page_id();
+    std::lock_guard lock(_page_locks[pageId % PAGE_LOCK_COUNT]);
+    if (!swip.is_evicted() || swip.page_id() != pageId) {
+        return nullptr;
+    }
+    auto *bf = _allocate_frame(page_size_class(pageId));
+    bf->page_id = pageId;
+    bf->loading.store(true, std::memory_order_relaxed);
+    // Publishes the loading flag along with the frame.
+    swip.swizzle(bf);
+    return bf;
+}
+
+void BufferManager::_load_pages(std::span<BufferFrame *const> frames) {
+    auto requests = std::vector<PageIO>{};
+    requests.reserve(frames.size());
+    for (auto *frame: frames) {
+        requests.push_back({frame->page.data(), frame->page_id});
+    }
+    const auto start = StatisticsCollector::start();
+    _ssd_region->read_pages(requests);
+    _record_io(false, requests, start);
+    for (auto *frame: frames) {
+        frame->loading.store(false, std::memory_order_release);
+        frame->loading.notify_all();
+    }
+}
+
+void BufferManager::_run_prefetcher() {
+    std::unique_lock lock(_prefetch_mutex);
+    while (true) {
+        _prefetch_wakeup.wait(lock, [this]() { return !_prefetch_queue.empty() || !_prefetcher_running; });
+        if (_prefetch_queue.empty()) {
+            // Stopped, and all prefetches are finished.
+            return;
+        }
+        auto frames = std::move(_prefetch_queue);
+        _prefetch_queue.clear();
+        lock.unlock();
+        _load_pages(frames);
+        lock.lock();
+    }
+}
+
+void BufferManager::_wait_for_load(BufferFrame *frame) {
+    frame->loading.wait(true, std::memory_order_acquire);
+}
+
+void BufferManager::_trace_access(Swip &swip, AccessMode mode) {
+    const auto operation = mode == AccessMode::SCAN ? TraceOperation::SCAN : TraceOperation::GET;
+    // Load the swip once, its state might change concurrently.
+    auto snapshot = Swip(swip.buffer_frame());
+    if (snapshot.is_evicted()) {
+        _trace->record({snapshot.page_id(), operation, TraceState::EVICTED});
+        return;
+    }
+    const auto state = snapshot.is_cooling() ? TraceState::COOLING : TraceState::HOT;
+    _trace->record({snapshot.buffer_frame_ignore_tags()->page_id, operation, state});
+}
+
+void BufferManager::_record_io(bool write, std::span<const PageIO> requests,
+                               StatisticsCollector::Clock::time_point start) {
+    if constexpr (!COLLECT_STATISTICS) {
+        return;
+    }
+    uint64_t bytes = 0;
+    for (const auto &request: requests) {
+        bytes += page_size(page_size_class(request.page_id));
+    }
+    _statistics.add(write ? Counter::PAGES_WRITTEN : Counter::PAGES_READ, requests.size());
+    _statistics.add(write ? Counter::BYTES_WRITTEN : Counter::BYTES_READ, bytes);
+    _statistics.record(write ? Latency::WRITE : Latency::READ, start);
 }
 
 BufferFrame *BufferManager::_random_frame() {
     // Do not modify.
     const uint64_t random_frame_offset = _distribution(_random_generator);
-    return _volatile_region->frames() + random_frame_offset;
+    return _volatile_region->frame_at(random_frame_offset);
 }
 
 void BufferManager::_create_cooling_state_share(const BufferFrame * const bf) {
+    std::unique_lock lock(_sampling_mutex, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        // Another thread is already sampling.
+        return;
+    }
+    _adapt_cooling_target();
+
     // check if currently used frames = FRAME_COUNT_MAX - _volatile_region->free_frame_count() smaller than we need
     if (FRAME_COUNT_MAX - _volatile_region->free_frame_count() < FIFTY_PERCENT_FRAMES) {
         // we don't have the needed amount of frames for things to be cooled
@@ -143,39 +737,97 @@ void BufferManager::_create_cooling_state_share(const BufferFrame * const bf) {
     }
 
     // if we do -> add as much to cooling state as we need to reach quota
-    while (_eviction_candidate_count() < FRAMES_NEEDED_IN_COOLING_STAGE) {
-        auto eviction_candidate = _random_frame();
-        // if swip is not hot -> already evicted, cooling or free -> get new random frame
-
-        if (eviction_candidate->page_id == INVALID_PAGE_ID || eviction_candidate == bf) {
-            continue;
+    // Other threads can free, load, or latch frames concurrently, thus we give up after sampling too many frames.
+    uint64_t attempts = 0;
+    const auto cooling_target = _cooling_target.load(std::memory_order_relaxed);
+    for (; _eviction_candidate_count() < cooling_target &&
+           attempts < MAX_SAMPLING_ATTEMPTS_PER_FRAME * FRAME_COUNT_MAX; ++attempts) {
+        // Free and cooling frames are skipped via the occupancy bitmap, without touching them
+        // (this is only a hint, `_add_eviction_candidate` re-checks it while holding the frame's latch)
+        auto eviction_candidate = _volatile_region->next_hot_frame(_random_frame());
+        if (!eviction_candidate) {
+            // no frame is hot
+            break;
         }
-
-        if (!_callbacks.iterate_children) {
-            _add_eviction_candidate(eviction_candidate);
+        if (eviction_candidate == bf) {
             continue;
         }
 
-        // we found a hot one -> check if all its children are not hot -> then we can use it
-        // otherwise use the children -> children might need to propagate down again
-        // when deleting: children could already be not evicted
-        auto childrenIsSwizzledIteratorFunction = [&eviction_candidate](Swip &swip) {
-            if (swip.is_swizzled()) {
-                eviction_candidate = swip.buffer_frame();
-                return true;
-            }
+        _cool_frame_or_descendant(eviction_candidate);
+    }
+    _statistics.add(Counter::SAMPLING_ITERATIONS, attempts);
+}
+
+void BufferManager::_adapt_cooling_target() {
+    if (!_cooling_stage_config.adaptive) {
+        return;
+    }
+    const auto target = _cooling_target.load(std::memory_order_relaxed);
+    const auto rescued = _rescued_since_adaptation.load(std::memory_order_relaxed);
+    const auto evicted = _evicted_since_adaptation.load(std::memory_order_relaxed);
+    if (rescued + evicted < std::max(target, MIN_COOLING_ADAPTATION_INTERVAL)) {
+        return;
+    }
+    // Other threads keep counting concurrently, thus we only subtract what we have seen.
+    _rescued_since_adaptation.fetch_sub(rescued, std::memory_order_relaxed);
+    _evicted_since_adaptation.fetch_sub(evicted, std::memory_order_relaxed);
+
+    const auto rescue_share = static_cast<double>(rescued) / static_cast<double>(rescued + evicted);
+    const auto step = std::max<uint64_t>(static_cast<uint64_t>(target * _cooling_stage_config.adaptation_step), 1);
+    if (rescue_share > _cooling_stage_config.max_rescue_share && target > _min_cooling_target) {
+        _cooling_target.store(std::max(target - std::min(step, target), _min_cooling_target),
+                              std::memory_order_relaxed);
+        _statistics.add(Counter::COOLING_TARGET_DECREASES);
+    } else if (rescue_share < _cooling_stage_config.min_rescue_share && target < _max_cooling_target) {
+        _cooling_target.store(std::min(target + step, _max_cooling_target), std::memory_order_relaxed);
+        _statistics.add(Counter::COOLING_TARGET_INCREASES);
+    }
+}
+
+bool BufferManager::_cool_frame_or_descendant(BufferFrame *frame) {
+    if (_callback_dispatch == &TYPE_ERASED_CALLBACK_DISPATCH && !_callbacks.iterate_children) {
+        return _add_eviction_candidate(frame);
+    }
+
+    // we found a hot one -> check if all its children are not hot -> then we can use it
+    // otherwise use the children -> children might need to propagate down again
+    // when deleting: children could already be not evicted
+    while (true) {
+        // The data structure might modify the page concurrently, thus we iterate while holding the frame's latch.
+        if (!frame->latch.try_lock_shared()) {
             return false;
-        };
+        }
+        auto *child = _callback_dispatch->swizzled_child(_callbacks, frame);
+        frame->latch.unlock_shared();
+        // check that at least one child is swizzled
+        if (child == nullptr) {
+            // we found one candidate -> thus we can add it to the eviction candidates and unswizzle its pointer
+            return _add_eviction_candidate(frame);
+        }
+        frame = child;
+    }
+}
 
-        while (true) {
-            bool atleastOneChildrenIsSwizzled = _callbacks.iterate_children(eviction_candidate,
-                                                                            childrenIsSwizzledIteratorFunction);
-            // check that at least one child is swizzled
-            if (!atleastOneChildrenIsSwizzled) {
-                // we found one candidate -> thus we can add it to the eviction candidates and unswizzle its pointer
-                _add_eviction_candidate(eviction_candidate);
-                break;
-            }
+bool BufferManager::_cool_frame_of_size_class(PageSizeClass size_class) {
+    const auto frame_count = _volatile_region->frame_count(size_class);
+    if (frame_count == 0) {
+        return false;
+    }
+    std::lock_guard lock(_sampling_mutex);
+    auto distribution = std::uniform_int_distribution<uint64_t>(0, frame_count - 1);
+    uint64_t attempts = 0;
+    for (; attempts < MAX_SAMPLING_ATTEMPTS_PER_FRAME * frame_count; ++attempts) {
+        // (the bitmap is only a hint, `_add_eviction_candidate` re-checks the frame while holding its latch)
+        auto *frame = _volatile_region->next_hot_frame(
+                _volatile_region->frame_at(size_class, distribution(_random_generator)));
+        if (!frame) {
+            break;
+        }
+        if (_cool_frame_or_descendant(frame)) {
+            _statistics.add(Counter::SAMPLING_ITERATIONS, attempts + 1);
+            return true;
         }
     }
+    _statistics.add(Counter::SAMPLING_ITERATIONS, attempts);
+    return false;
 }
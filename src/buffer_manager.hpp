@@ -1,21 +1,43 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <condition_variable>
+#include <filesystem>
 #include <functional>
-#include <list>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <random>
-#include <unordered_map>
+#include <span>
+#include <thread>
+#include <vector>
 
+#include "access_trace.hpp"
 #include "buffer_frame.hpp"
+#include "config.hpp"
+#include "cooling_queue.hpp"
 #include "data_regions.hpp"
+#include "statistics.hpp"
 #include "swip.hpp"
 
 // Share of pages in cooling stage. Do not modify.
-constexpr float SHARE_COOLING_PAGES = 0.1f;
+constexpr float SHARE_COOLING_PAGES = BM_SHARE_COOLING_PAGES;
 // Share of the free frames that has to be achieved so that the number of eviction candidates gets maintained.
 // We round down, i.e., static_cast<some uint type>(frame_count * SHARE_USED_PAGES_BEFORE_COOLING) should be
 // sufficient to calculate the number of used candidates.
-constexpr float SHARE_USED_PAGES_BEFORE_COOLING = 0.5f;
+constexpr float SHARE_USED_PAGES_BEFORE_COOLING = BM_SHARE_USED_PAGES_BEFORE_COOLING;
+// Upper bound of random frames sampled per frame of the pool until the cooling stage has to be filled. This only
+// matters if most frames are latched, free, or cooling concurrently.
+constexpr uint64_t MAX_SAMPLING_ATTEMPTS_PER_FRAME = 4;
+// Minimum number of frames that leave the cooling stage (rescued or evicted) between two adaptations of the cooling
+// target (see `CoolingStageConfig::adaptive`).
+constexpr uint64_t MIN_COOLING_ADAPTATION_INTERVAL = 64;
+// Maximum number of pages written with one batch when a dirty page is evicted. Other dirty eviction candidates of the
+// same partition are written along, so that runs of adjacent pages are coalesced (see `SSDRegion::write_pages`).
+constexpr uint64_t EVICTION_WRITE_BATCH_SIZE = 32;
 
 // Base class for all concrete data structures that can be managed by the buffer manager.
 struct ManagedDataStructure {};
@@ -23,11 +45,18 @@ struct ManagedDataStructure {};
 // ----- Callback functions (see Paper IV. E.)
 // Callback function to iterate over a page's child swips. This is necessary to check if a randomly picked page has
 // swizzled child pages. If a swizzled child swip is found, set `frame` to the swizzled child's frame and return true.
-// If no swizzled child was found, frame does not get changed and the function returns false.
+// If no swizzled child was found, frame does not get changed and the function returns false. The buffer manager holds
+// the frame's latch while calling the function. It also uses the function to check that a page has no child pages in
+// memory before evicting it, since the page could not be written back otherwise.
 using Functor = std::function<bool(Swip&)>;
 using IterateChildSwipsFunction = std::function<bool(BufferFrame* frame, Functor)>;
 
-// Callback function to get the parent swip of a given frame.
+// Callback function to get the parent swip of a given frame. If the data structure sets `BufferFrame::parent_frame`
+// (e.g., in `get_frame`), the buffer manager latches the parent frame in shared mode while it unswizzles or evicts the
+// swip, so that the data structure can move swips while holding the parent's latch exclusively. Since a child can thus
+// be evicted while a thread holds the parent's latch in shared mode, such threads have to check that the swip still
+// references the frame after latching it. Evicting a page marks its parent frame dirty, since the swip stored in the
+// parent's page changes.
 using GetParentFunction = std::function<Swip&(BufferFrame* frame, ManagedDataStructure* data_structure)>;
 
 struct Callbacks {
@@ -35,20 +64,107 @@ struct Callbacks {
   GetParentFunction get_parent = nullptr;
 };
 
+// Alternative to `Callbacks` for data structures that provide the callback functions as static member functions (see
+// `BufferManager::register_static_callbacks`). The buffer manager then calls them through functions instantiated for
+// the data structure type, thus the data structure's functions and the per-child functor are inlined instead of being
+// called through `std::function`. Both functions have the semantics of their `Callbacks` counterparts, and
+// `iterate_children` has to accept any callable with the signature of `Functor`.
+template <typename T>
+concept ProvidesCallbacks =
+    std::derived_from<T, ManagedDataStructure> &&
+    requires(BufferFrame* frame, ManagedDataStructure* data_structure, bool (*functor)(Swip&)) {
+      { T::iterate_children(frame, functor) } -> std::same_as<bool>;
+      { T::get_parent(frame, data_structure) } -> std::same_as<Swip&>;
+    };
+
+// Access hint for `BufferManager::get_frame`.
+enum class AccessMode {
+  // Pages are hot after they were accessed.
+  NORMAL,
+  // Sequential sweep, e.g., of an analytical scan, that is not expected to access the pages again soon. Pages loaded
+  // for the scan go straight to the end of the cooling stage, thus the scan keeps reusing the frames of its own pages
+  // instead of evicting the hot pages of other workloads. Pages that are cooling stay cooling, hot pages stay hot, and
+  // the scan does not trigger sampling. A scan page that is accessed normally afterwards becomes hot as usual.
+  SCAN
+};
+
+// Runtime configuration of the cooling stage. The defaults are the compile-time shares (see config.hpp), other shares
+// let a program compare configurations without recompiling, e.g., when replaying a trace (see test/trace_replay.cpp).
+struct CoolingStageConfig {
+  // Share of the frames kept in the cooling stage (see `SHARE_COOLING_PAGES`).
+  float share_cooling_pages = SHARE_COOLING_PAGES;
+  // Share of the frames that has to be in use before the cooling stage is maintained (see
+  // `SHARE_USED_PAGES_BEFORE_COOLING`).
+  float share_used_pages_before_cooling = SHARE_USED_PAGES_BEFORE_COOLING;
+
+  // Adapts the number of frames kept in the cooling stage (the cooling target) at runtime, starting with
+  // `share_cooling_pages`. Frames leave the cooling stage either rescued, i.e., accessed again and swizzled, or
+  // evicted. If a large share of them is rescued, the stage holds hot pages that are unswizzled and swizzled again for
+  // nothing, thus the target shrinks. If hardly any are rescued, pages are evicted without getting a second chance,
+  // thus the target grows. The target is adapted once about as many frames left the stage as the target holds (at
+  // least MIN_COOLING_ADAPTATION_INTERVAL), by `adaptation_step` of the current target, within the given shares of the
+  // frames. See `BufferManager::cooling_target` and `Statistics`.
+  bool adaptive = false;
+  float min_share_cooling_pages = 0.01f;
+  float max_share_cooling_pages = 0.5f;
+  // Band of the share of rescued frames within which the target stays unchanged.
+  float min_rescue_share = 0.05f;
+  float max_rescue_share = 0.25f;
+  float adaptation_step = 0.125f;
+};
+
+// Configuration of the optional background page provider (see `BufferManager::start_page_provider`).
+struct PageProviderConfig {
+  // Number of free frames the page provider keeps available. Foreground threads only evict pages themselves if no free
+  // frame is left.
+  uint64_t free_frames_target = 16;
+
+  // The page provider is woken up by allocations that drop the number of free frames below the target. Independently,
+  // it checks the free frames in this interval.
+  std::chrono::microseconds interval{1000};
+};
+
+// Configuration of the optional background writer (see `BufferManager::start_background_writer`).
+struct BackgroundWriterConfig {
+  // Maximum number of dirty eviction candidates written back with one batch.
+  uint64_t batch_size = 64;
+
+  // The background writer keeps writing batches while it finds full batches of dirty candidates. Otherwise, it checks
+  // the cooling stage again in this interval.
+  std::chrono::microseconds interval{1000};
+};
+
 class BufferManager {
  public:
-  BufferManager(std::unique_ptr<VolatileRegion> volatile_region, std::unique_ptr<SSDRegion> ssd_region);
+  BufferManager(std::unique_ptr<VolatileRegion> volatile_region, std::unique_ptr<SSDRegion> ssd_region,
+                CoolingStageConfig cooling_stage_config = {});
+
+  // Stops the background threads if they are running and waits for outstanding prefetches.
+  ~BufferManager();
 
   // Allocates a new frame with the next available page id. For the tests and benchmark, you can assume than the SSD
   // region has enough pages. If you run into an issue here, you are probably allocating too many page IDs.
   //
   // If no more frames are available, another frame needs to be evicted. To evict a page, we need a certain number of
-  // eviction candidates, i.e., frames in the cooling stage. This task is single-threaded and the number of eviction
-  // candidates needs to be ensured synchronously. We ensure the number of candidates only when we have already
+  // eviction candidates, i.e., frames in the cooling stage. The number of eviction candidates needs to be ensured
+  // synchronously. We ensure the number of candidates only when we have already
   // allocated 50% of the available frames. We ensure the number of eviction candidates when (1) a new page is
   // allocated, or (2) a cold page needs to be loaded into a frame and thus a free frame is required. In this function,
   // we ensure the number of eviction candidates after allocating the frame.
-  BufferFrame* allocate_page();
+  //
+  // The frame and the page are of the given size class (see `PageSizeClass`). If no frame of the size class is free,
+  // eviction candidates of the size class are evicted.
+  //
+  // All public functions are thread-safe. The cooling stage is split into the same partitions as the volatile region's
+  // free frames (see `VolatileRegion`), each protected by its own lock, and evictions start at the calling thread's
+  // home partition. Swizzled swips are resolved without taking a lock. Frames are only evicted while their latch can be
+  // acquired exclusively, so a thread holding a frame's latch (in shared or exclusive mode) keeps the frame from being
+  // evicted.
+  BufferFrame* allocate_page(PageSizeClass size_class = PageSizeClass::SIZE_4K);
+
+  // Like `allocate_page`, but returns the frame latched exclusively. The frame can thus not be cooled or evicted before
+  // the caller made it reachable, e.g., by storing its swip in a parent node and setting its `parent_frame`.
+  BufferFrame* allocate_page_latched(PageSizeClass size_class = PageSizeClass::SIZE_4K);
 
   // Frees the frame and the corresponding page id.
   void free_page(BufferFrame* frame);
@@ -64,7 +180,70 @@ class BufferManager {
   // the swip is evicted. In this case, this function has to ensure the required number of eviction candidates after
   // allocating a frame for the page to be loaded. Feel free to add more helper functions to avoid writing redundant
   // code.
-  BufferFrame* get_frame(Swip& swip);
+  //
+  // With `AccessMode::SCAN`, loaded pages are not made hot (see `AccessMode`). If the swip is stored in the page of
+  // another frame, pass this frame as `parent`. It becomes the `parent_frame` of a loaded frame before the frame is
+  // published. Loading a page may evict other pages, thus the caller must not hold the parent's latch exclusively if
+  // the swip is evicted.
+  BufferFrame* get_frame(Swip& swip, AccessMode mode = AccessMode::NORMAL, BufferFrame* parent = nullptr);
+
+  // Starts loading the page of an evicted swip in the background. A frame is reserved and the swip is swizzled right
+  // away, while the read runs on a background thread (batched via `SSDRegion::read_pages`). A later `get_frame` on the
+  // swip thus finds it swizzled and only waits for the remainder of the read. Swips that are not evicted are ignored.
+  // The swips are not accessed after the call returns.
+  void prefetch(Swip& swip);
+
+  // Prefetches the pages of all evicted swips (see above), e.g., the children of an inner node ahead of a range scan.
+  // The reads of all swips are submitted as one batch.
+  void prefetch(std::span<Swip> swips);
+
+  // Resolves all swips like `get_frame` and stores the frame of `*swips[i]` in `frames[i]`, which must have room for
+  // all swips. The swips are classified in one pass: swizzled and cooling swips are resolved right away, while a frame
+  // is reserved for every evicted swip and all of them are read with one batch (see `SSDRegion::read_pages`). Returns
+  // once all pages are loaded. The number of evicted swips must be smaller than the number of frames of their size
+  // class, since the reserved frames cannot be evicted until the batch is read.
+  void get_frames(std::span<Swip* const> swips, std::span<BufferFrame*> frames);
+
+  // Makes all pages written back so far durable (see `SSDRegion::sync`). Depending on the SSD region's sync policy,
+  // flushing a page during an eviction does not wait for the device.
+  void sync();
+
+  // Starts a background thread that keeps `config.free_frames_target` frames free and maintains the cooling stage, so
+  // that allocations and misses mostly pop a free frame instead of sampling and evicting on the caller's path (see
+  // LeanStore, Section IV. G.). Since pages are evicted concurrently, frames must only be accessed while holding their
+  // latch and callers have to check the frame's page ID after latching it (see `get_frame`). Does nothing if the
+  // provider is already running.
+  void start_page_provider(PageProviderConfig config = {});
+
+  // Stops the page provider and waits for its thread to finish.
+  void stop_page_provider();
+
+  // Starts a background thread that writes dirty eviction candidates back ahead of their eviction, oldest first, so
+  // that evictions mostly find clean frames and do not have to wait for a write (and possibly a sync) on the caller's
+  // path. Pages are written while holding the frame's latch in shared mode, thus callers must only modify a page while
+  // holding its frame's latch exclusively. Does nothing if the writer is already running.
+  void start_background_writer(BackgroundWriterConfig config = {});
+
+  // Stops the background writer and waits for its thread to finish.
+  void stop_background_writer();
+
+  // Returns the statistics collected since the buffer manager was created (see `Statistics`). The counters are kept per
+  // thread and summed up by this call, thus recording them does not synchronize the threads.
+  Statistics statistics() const;
+
+  // Returns the number of frames the cooling stage is filled up to, which changes at runtime if the cooling stage is
+  // adaptive (see `CoolingStageConfig::adaptive`).
+  uint64_t cooling_target() const;
+
+  // Records every `get_frame`, `get_frames`, `allocate_page`, and `free_page` call to a trace file at `path` (see
+  // access_trace.hpp), e.g., to replay the accesses with other pool sizes and cooling shares. A running trace is
+  // stopped first. Prefetches are not recorded. The page ID of a hot or cooling page is read from its frame without
+  // latching it, thus it might be stale if the page is evicted concurrently. Like `register_callbacks`, starting and
+  // stopping a trace is not thread-safe, i.e., no other thread may use the buffer manager meanwhile.
+  void start_trace(const std::filesystem::path& path);
+
+  // Writes the remaining records of the trace and closes its file.
+  void stop_trace();
 
   // Register the callback functions.
   void register_callbacks(Callbacks&& callbacks);
@@ -72,25 +251,36 @@ class BufferManager {
   // Registers a data structure. This might be relevant for a concrete data structure's callback functions.
   void register_data_structure(ManagedDataStructure* data_structure);
 
+  // Registers the data structure and uses the static callback functions of its type instead of the registered
+  // `Callbacks` (see `ProvidesCallbacks`). Registering type-erased callbacks afterwards switches back to them.
+  template <ProvidesCallbacks T>
+  void register_static_callbacks(T* data_structure) {
+    _managed_data_structure = data_structure;
+    _callback_dispatch = &STATIC_CALLBACK_DISPATCH<T>;
+  }
+
   // --- The below variables and functions do not necessarily need to be public. However, this makes testing much
   // easier.
 
   // Flushed the page of the passed buffer frame.
   void _flush(BufferFrame* frame);
 
-  // Evicts a page. The cooling stage to be implemented determines which page to evict.
-  void _evict_page();
+  // Evicts a page. The cooling stage to be implemented determines which page to evict. Returns false if every eviction
+  // candidate is currently latched by another thread. The following helper functions synchronize internally.
+  bool _evict_page();
 
   // Checks if the passed buffer frame is an eviction candidate. In terms of the second chance lean eviction policy
   // described in the paper, this function checks if the frame is in the cooling stage.
   bool _has_eviction_candidate(BufferFrame* frame);
 
-  // Pops and returns the frame that is to be evicted.
+  // Pops and returns the frame that is to be evicted, starting with the calling thread's home partition. Returns nullptr
+  // if the cooling stage is empty.
   BufferFrame* _pop_eviction_candidate();
 
   // Adds the passed frame to the set of eviction candidates. In terms of the second chance eviction policy, this
-  // function adds the frame to the cooling stage.
-  void _add_eviction_candidate(BufferFrame* frame);
+  // function adds the frame to the cooling stage. Frames that are free or latched exclusively (i.e., a page is being
+  // loaded into them or they are being evicted) are not added. Returns whether the frame was added.
+  bool _add_eviction_candidate(BufferFrame* frame);
 
   // Removes the passed frame from the set of eviction candidates (if it is present).
   void _remove_eviction_candidate(BufferFrame* frame);
@@ -98,10 +288,14 @@ class BufferManager {
   // Returns the number of frames in the set of eviction candidates.
   uint32_t _eviction_candidate_count();
 
+  // Writes back up to `max_count` dirty eviction candidates with one batch, starting with the oldest candidate of each
+  // partition. Candidates latched by other threads are skipped. Returns the number of pages written.
+  uint64_t _write_back_eviction_candidates(uint64_t max_count);
+
   std::unique_ptr<VolatileRegion> _volatile_region;
   std::unique_ptr<SSDRegion> _ssd_region;
   Callbacks _callbacks;
-  ManagedDataStructure* _managed_data_structure;
+  ManagedDataStructure* _managed_data_structure = nullptr;
 
   // Random number generation
   std::mt19937 _random_generator;
@@ -111,14 +305,179 @@ class BufferManager {
   // Chooses a random frame. Do not modify the code.
   BufferFrame* _random_frame();
 
-  // IDEA: https://stackoverflow.com/questions/8619404/hash-list-with-stl-can-i-point-to-an-item-in-an-stl-list-to-another-item/8619656#8619656
-  std::unordered_map<BufferFrame*, std::list<BufferFrame*>::iterator> fast_access = {};
-  std::list<BufferFrame*> eviction_list = {};
+  // Functions through which the callbacks are called, either type-erased (`_callbacks`) or instantiated for a data
+  // structure type (see `ProvidesCallbacks`).
+  struct CallbackDispatch {
+    // Returns the frame of a swizzled child of the frame, or nullptr if no child is swizzled.
+    BufferFrame* (*swizzled_child)(const Callbacks& callbacks, BufferFrame* frame);
+    // Returns whether a child page of the frame is swizzled or cooling.
+    bool (*has_resident_children)(const Callbacks& callbacks, BufferFrame* frame);
+    // Returns the frame's parent swip, or nullptr without a `get_parent` callback.
+    Swip* (*parent_swip)(const Callbacks& callbacks, BufferFrame* frame, ManagedDataStructure* data_structure);
+  };
+
+  static const CallbackDispatch TYPE_ERASED_CALLBACK_DISPATCH;
+
+  template <ProvidesCallbacks T>
+  static constexpr CallbackDispatch STATIC_CALLBACK_DISPATCH = {
+      [](const Callbacks&, BufferFrame* frame) -> BufferFrame* {
+        BufferFrame* child = nullptr;
+        T::iterate_children(frame, [&child](Swip& swip) {
+          if (swip.is_swizzled()) {
+            child = swip.buffer_frame();
+            return true;
+          }
+          return false;
+        });
+        return child;
+      },
+      [](const Callbacks&, BufferFrame* frame) {
+        return T::iterate_children(frame, [](Swip& swip) { return !swip.is_evicted(); });
+      },
+      [](const Callbacks&, BufferFrame* frame, ManagedDataStructure* data_structure) {
+        return &T::get_parent(frame, data_structure);
+      }};
+
+  // Dispatch of the registered callbacks (see `register_callbacks` and `register_static_callbacks`).
+  const CallbackDispatch* _callback_dispatch = &TYPE_ERASED_CALLBACK_DISPATCH;
 
+  // One partition of the cooling stage. The oldest eviction candidate is at the front. Cache line aligned to avoid
+  // false sharing between partitions.
+  struct alignas(64) CoolingPartition {
+    std::mutex mutex;
+    CoolingQueue queue{};
+  };
+
+  CoolingPartition& _cooling_partition(const BufferFrame* frame);
+
+  // Returns a free frame of the size class, evicting pages if no frame is free.
+  BufferFrame* _allocate_frame(PageSizeClass size_class);
+
+  // Evicts the oldest eviction candidate that is not latched, only considering frames of the size class if one is given.
+  bool _evict_candidate(std::optional<PageSizeClass> size_class);
+
+  // Adds the frame to the cooling stage, or one of its descendants if the frame has swizzled children. Returns whether
+  // a frame was added.
+  bool _cool_frame_or_descendant(BufferFrame* frame);
+
+  // Samples frames of the size class until one of them (or one of their descendants) is added to the cooling stage.
+  // Required if the cooling stage only holds frames of other size classes. Returns false if no frame could be added.
+  bool _cool_frame_of_size_class(PageSizeClass size_class);
+
+  // Loads the page of the evicted swip into a new frame and swizzles the swip. Returns nullptr if another thread
+  // resolved the swip in the meantime.
+  BufferFrame* _load_page(Swip& swip, BufferFrame* parent);
+
+  // Latches the frame's parent frame (see `GetParentFunction`) in shared mode. Returns false if the parent is latched
+  // exclusively. Frames without a parent frame succeed without latching.
+  bool _try_lock_parent(BufferFrame* frame);
+
+  // Releases the latch acquired by `_try_lock_parent`.
+  void _unlock_parent(BufferFrame* frame);
+
+  // Returns whether a child page of the frame is swizzled or cooling. Expects the frame's latch to be held.
+  bool _has_resident_children(BufferFrame* frame);
+
+  // Ensures the number of eviction candidates. Only one thread samples at a time, others skip sampling while the
+  // sampling lock is taken.
   void _create_cooling_state_share(const BufferFrame* bf);
 
+  // Adapts the cooling target to the share of rescued frames if the cooling stage is adaptive (see
+  // `CoolingStageConfig::adaptive`). Expects the sampling lock to be held.
+  void _adapt_cooling_target();
+
+  // Lets threads holding latches of all eviction candidates proceed.
+  void _wait_for_eviction_progress();
+
+  // Wakes up the page provider if the number of free frames dropped below its target.
+  void _notify_page_provider();
+
+  // Main loop of the page provider thread.
+  void _run_page_provider();
+
+  // Appends dirty eviction candidates of the partition to `frames`, oldest first, until it holds `max_count` frames.
+  // Their latches are acquired in shared mode, candidates latched by other threads are skipped. Expects the partition's
+  // lock to be held.
+  void _collect_dirty_candidates(CoolingPartition& partition, uint64_t max_count, std::vector<BufferFrame*>& frames);
+
+  // Marks the latched frames as written back and writes their pages with one batch. A frame marked dirty concurrently
+  // (see `GetParentFunction`) stays dirty.
+  void _write_back(std::span<BufferFrame* const> frames);
+
+  // Main loop of the background writer thread.
+  void _run_background_writer();
+
+  // Adds the frame of a page loaded by a scan to the end of the cooling stage and unswizzles the swip.
+  void _add_scan_frame(BufferFrame* frame, Swip& swip);
+
+  // Swizzles a cooling swip and removes its frame from the cooling stage. Returns nullptr if the swip changed its state
+  // concurrently.
+  BufferFrame* _swizzle_cooling(Swip& swip);
+
+  // Reserves a frame for the page of an evicted swip, marks it as loading, and swizzles the swip. The page still has to
+  // be read (see `_load_pages`). Returns nullptr if the swip is not evicted anymore.
+  BufferFrame* _reserve_frame(Swip& swip);
+
+  // Reads the pages of reserved frames with one batch and clears their loading flags.
+  void _load_pages(std::span<BufferFrame* const> frames);
+
+  // Main loop of the prefetch thread. Reads the pages of all queued frames (see `_load_pages`).
+  void _run_prefetcher();
+
+  // Waits until a prefetched page is loaded into the frame.
+  static void _wait_for_load(BufferFrame* frame);
+
+  // Records an access to the swip's page in the trace.
+  void _trace_access(Swip& swip, AccessMode mode);
+
+  // Records a read or write of the pages with one call of the SSD region that started at `start`.
+  void _record_io(bool write, std::span<const PageIO> requests, StatisticsCollector::Clock::time_point start);
+
+  StatisticsCollector _statistics;
+
+  // Trace of page accesses, nullptr unless a trace is recorded (see `start_trace`).
+  std::unique_ptr<AccessTraceWriter> _trace;
+
+  std::vector<CoolingPartition> _cooling_partitions;
+  std::atomic<uint64_t> _cooling_count{0};
+
+  // Protects the random number generation in `_create_cooling_state_share`.
+  std::mutex _sampling_mutex;
+
+  // Serializes loading evicted pages with the same page ID, so that a page is never loaded into two frames.
+  static constexpr uint64_t PAGE_LOCK_COUNT = 256;
+  std::array<std::mutex, PAGE_LOCK_COUNT> _page_locks;
+
+  std::thread _page_provider;
+  std::atomic<bool> _page_provider_running = false;
+  PageProviderConfig _page_provider_config{};
+  std::mutex _page_provider_mutex;
+  std::condition_variable _page_provider_wakeup;
+
+  std::thread _background_writer;
+  bool _background_writer_running = false;
+  BackgroundWriterConfig _background_writer_config{};
+  std::mutex _background_writer_mutex;
+  std::condition_variable _background_writer_wakeup;
+
+  // Frames whose pages are to be read by the prefetch thread, which is started on the first prefetch.
+  std::thread _prefetcher;
+  bool _prefetcher_running = false;
+  std::vector<BufferFrame*> _prefetch_queue;
+  std::mutex _prefetch_mutex;
+  std::condition_variable _prefetch_wakeup;
+
 
   const uint64_t FRAME_COUNT_MAX;
   const uint64_t FRAMES_NEEDED_IN_COOLING_STAGE;
   const uint64_t FIFTY_PERCENT_FRAMES;
+
+  const CoolingStageConfig _cooling_stage_config;
+  // Initially FRAMES_NEEDED_IN_COOLING_STAGE, adapted while holding the sampling lock.
+  std::atomic<uint64_t> _cooling_target;
+  const uint64_t _min_cooling_target;
+  const uint64_t _max_cooling_target;
+  // Frames that left the cooling stage since the last adaptation. Only counted if the cooling stage is adaptive.
+  std::atomic<uint64_t> _rescued_since_adaptation{0};
+  std::atomic<uint64_t> _evicted_since_adaptation{0};
 };
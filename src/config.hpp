@@ -0,0 +1,73 @@
+#pragma once
+
+// Compile-time configuration of the buffer manager. Every knob can be overridden by defining the macro when compiling
+// the library and everything that includes its headers, e.g., via the CMake cache variables of the same name (see
+// CMakeLists.txt). All derived constants are constexpr, so an instantiation with a different configuration is folded
+// just like the defaults. Since the values change the layout of `Page`, `BufferFrame`, and `Swip`, all translation units
+// of a program must be compiled with the same configuration.
+
+// Size of a page of the smallest size class in bytes. Must be a power of two and a multiple of BM_PAGE_ALIGNMENT.
+#ifndef BM_PAGE_SIZE
+#define BM_PAGE_SIZE 4096
+#endif
+
+// Alignment of pages and frames in bytes. O_DIRECT requires at least 512 bytes, devices with 4 KiB sectors 4096 bytes.
+#ifndef BM_PAGE_ALIGNMENT
+#define BM_PAGE_ALIGNMENT 512
+#endif
+
+// Number of the swip's least significant bits used for tagging. Page IDs are shifted by this number of bits, thus more
+// tag bits leave fewer bits for page IDs. The tag bits must be zero in every frame address, see BM_PAGE_ALIGNMENT.
+#ifndef BM_SWIP_TAG_BITS
+#define BM_SWIP_TAG_BITS 2
+#endif
+
+// Tags of cooling and evicted swips. A swizzled swip has all tag bits cleared. Swizzling a cooling swip clears the
+// cooling tag's bits, thus they must not overlap with the evicted tag.
+#ifndef BM_SWIP_COOLING_TAG
+#define BM_SWIP_COOLING_TAG 2
+#endif
+
+#ifndef BM_SWIP_EVICTED_TAG
+#define BM_SWIP_EVICTED_TAG 1
+#endif
+
+// Share of the frames kept in the cooling stage.
+#ifndef BM_SHARE_COOLING_PAGES
+#define BM_SHARE_COOLING_PAGES 0.1f
+#endif
+
+// Share of the frames that has to be in use before the cooling stage is maintained.
+#ifndef BM_SHARE_USED_PAGES_BEFORE_COOLING
+#define BM_SHARE_USED_PAGES_BEFORE_COOLING 0.5f
+#endif
+
+// Layout of the frames in the volatile region. 0: every frame's metadata is interleaved with its page, i.e., the page
+// directly follows the metadata. 1: the metadata of all frames is stored in a dense array of descriptors, separate from
+// an arena of pages, so that sweeps over the metadata (sampling, the background writer) touch fewer cache lines and
+// TLB entries.
+#ifndef BM_DECOUPLED_FRAMES
+#define BM_DECOUPLED_FRAMES 0
+#endif
+
+// Whether the buffer manager collects statistics (see `BufferManager::statistics`). Recording a value only updates
+// counters of the calling thread, and latencies are only measured for I/O and misses.
+#ifndef BM_COLLECT_STATISTICS
+#define BM_COLLECT_STATISTICS 1
+#endif
+
+static_assert((BM_PAGE_ALIGNMENT & (BM_PAGE_ALIGNMENT - 1)) == 0 && BM_PAGE_ALIGNMENT >= 512,
+              "BM_PAGE_ALIGNMENT must be a power of two of at least 512 bytes");
+static_assert((BM_PAGE_SIZE & (BM_PAGE_SIZE - 1)) == 0 && BM_PAGE_SIZE >= BM_PAGE_ALIGNMENT,
+              "BM_PAGE_SIZE must be a power of two and a multiple of BM_PAGE_ALIGNMENT");
+static_assert(BM_SWIP_TAG_BITS >= 2 && (1 << BM_SWIP_TAG_BITS) <= BM_PAGE_ALIGNMENT,
+              "BM_SWIP_TAG_BITS must distinguish three states and fit into the alignment of frames");
+static_assert(BM_SWIP_COOLING_TAG > 0 && BM_SWIP_COOLING_TAG < (1 << BM_SWIP_TAG_BITS) &&
+                      BM_SWIP_EVICTED_TAG > 0 && BM_SWIP_EVICTED_TAG < (1 << BM_SWIP_TAG_BITS) &&
+                      (BM_SWIP_COOLING_TAG & BM_SWIP_EVICTED_TAG) == 0,
+              "Swip tags must be distinct, non-zero, non-overlapping, and fit into BM_SWIP_TAG_BITS");
+static_assert(!BM_DECOUPLED_FRAMES || (1 << BM_SWIP_TAG_BITS) <= 64,
+              "Decoupled frame descriptors are aligned to 64 bytes, thus BM_SWIP_TAG_BITS must fit into 6 bits");
+static_assert(BM_SHARE_COOLING_PAGES > 0 && BM_SHARE_COOLING_PAGES < 1 && BM_SHARE_USED_PAGES_BEFORE_COOLING >= 0 &&
+                      BM_SHARE_USED_PAGES_BEFORE_COOLING < 1,
+              "Cooling shares must be in [0, 1)");
@@ -0,0 +1,55 @@
+#include "cooling_queue.hpp"
+
+void CoolingQueue::push_back(BufferFrame* frame) {
+  frame->cooling = true;
+  frame->cooling_prev = _tail;
+  frame->cooling_next = nullptr;
+  if (_tail) {
+    _tail->cooling_next = frame;
+  } else {
+    _head = frame;
+  }
+  _tail = frame;
+  ++_size;
+}
+
+BufferFrame* CoolingQueue::pop_front() {
+  auto* frame = _head;
+  if (frame) {
+    remove(frame);
+  }
+  return frame;
+}
+
+BufferFrame* CoolingQueue::front() const {
+  return _head;
+}
+
+void CoolingQueue::remove(BufferFrame* frame) {
+  if (frame->cooling_prev) {
+    frame->cooling_prev->cooling_next = frame->cooling_next;
+  } else {
+    _head = frame->cooling_next;
+  }
+  if (frame->cooling_next) {
+    frame->cooling_next->cooling_prev = frame->cooling_prev;
+  } else {
+    _tail = frame->cooling_prev;
+  }
+  frame->cooling_prev = nullptr;
+  frame->cooling_next = nullptr;
+  frame->cooling = false;
+  --_size;
+}
+
+bool CoolingQueue::contains(const BufferFrame* frame) {
+  return frame->cooling;
+}
+
+uint64_t CoolingQueue::size() const {
+  return _size;
+}
+
+bool CoolingQueue::empty() const {
+  return _size == 0;
+}
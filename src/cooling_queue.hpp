@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+
+#include "buffer_frame.hpp"
+
+// Intrusive FIFO of the frames in the cooling stage. The links and the cooling flag are stored in the frames'
+// headers (see `BufferFrame::cooling_prev`), thus adding, removing, and checking frames neither allocates memory nor
+// requires a lookup. A frame can be in at most one cooling queue at a time. The queue is not synchronized.
+class CoolingQueue {
+ public:
+  // Appends the frame to the end of the queue. Expects that the frame is not in a queue.
+  void push_back(BufferFrame* frame);
+
+  // Removes and returns the first frame of the queue or nullptr if the queue is empty.
+  BufferFrame* pop_front();
+
+  // Returns the first frame of the queue or nullptr if the queue is empty. The following frames are linked via
+  // `BufferFrame::cooling_next`.
+  BufferFrame* front() const;
+
+  // Unlinks the frame from the queue. Expects that the frame is in this queue.
+  void remove(BufferFrame* frame);
+
+  // Returns whether the frame is in a cooling queue.
+  static bool contains(const BufferFrame* frame);
+
+  uint64_t size() const;
+
+  bool empty() const;
+
+ private:
+  BufferFrame* _head = nullptr;
+  BufferFrame* _tail = nullptr;
+  uint64_t _size = 0;
+};
@@ -1,39 +1,216 @@
 #include "data_regions.hpp"
 
+#include <fcntl.h>
+#include <linux/mempolicy.h>
 #include <sys/file.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
+#include <sys/syscall.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <bit>
+#include <climits>
 #include <cassert>
+#include <cerrno>
 #include <cstring>
+#include <fstream>
 #include <iostream>
+#include <new>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <thread>
 
 ///////////////////////////////////////////////////////////
 //// Volatile Region
 ///////////////////////////////////////////////////////////
 
-VolatileRegion::VolatileRegion(uint64_t frame_count) : _frame_count{frame_count} {
-    _data = reinterpret_cast<std::byte *>(mmap(nullptr, frame_count * sizeof(BufferFrame), PROT_READ | PROT_WRITE,
-                                               MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
-    madvise(_data, frame_count * sizeof(BufferFrame), MADV_HUGEPAGE);
+namespace {
+
+// Sequential IDs of the threads that use a volatile region, used to assign home partitions and magazines.
+uint64_t thread_id() {
+    static std::atomic<uint64_t> next_thread_id{0};
+    thread_local const uint64_t id = next_thread_id.fetch_add(1, std::memory_order_relaxed);
+    return id;
+}
+
+constexpr uint64_t STACK_INDEX_MASK = (uint64_t{1} << 32) - 1;
+
+// Size of the pages of the hugetlb pool (the default huge page size on x86-64) and of regular pages.
+constexpr uint64_t HUGE_PAGE_SIZE = 2 * MiB;
+constexpr uint64_t SMALL_PAGE_SIZE = 4 * KiB;
+
+uint64_t round_up(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// Returns the NUMA nodes that have memory, e.g., "0-1,3" in sysfs. Returns node 0 if sysfs cannot be read.
+std::vector<uint32_t> numa_nodes_with_memory() {
+    auto nodes = std::vector<uint32_t>{};
+    auto file = std::ifstream("/sys/devices/system/node/has_memory");
+    auto range = std::string{};
+    while (std::getline(file, range, ',')) {
+        uint32_t first = 0;
+        uint32_t last = 0;
+        char separator = 0;
+        auto stream = std::istringstream(range);
+        if (!(stream >> first)) {
+            continue;
+        }
+        if (!(stream >> separator >> last)) {
+            last = first;
+        }
+        for (auto node = first; node <= last; ++node) {
+            nodes.push_back(node);
+        }
+    }
+    return nodes.empty() ? std::vector<uint32_t>{0} : nodes;
+}
+
+// Sets the NUMA memory policy of the pages in [address, address + length). Failures are ignored.
+void bind_memory(std::byte *address, uint64_t length, int mode, std::span<const uint32_t> nodes) {
+    const auto max_node = *std::max_element(nodes.begin(), nodes.end());
+    // The kernel only considers `max_node - 1` bits of the mask, thus we pass one word more than necessary.
+    auto node_mask = std::vector<unsigned long>(max_node / 64 + 2, 0);
+    for (const auto node: nodes) {
+        node_mask[node / 64] |= 1ul << (node % 64);
+    }
+    syscall(__NR_mbind, address, length, mode, node_mask.data(), node_mask.size() * 64, 0);
+}
+
+}  // namespace
+
+VolatileRegion::VolatileRegion(uint64_t frame_count, uint64_t partition_count, const MemoryPolicy &memory_policy)
+        : VolatileRegion(std::array<uint64_t, PAGE_SIZE_CLASS_COUNT>{frame_count}, partition_count, memory_policy) {}
+
+VolatileRegion::VolatileRegion(const std::array<uint64_t, PAGE_SIZE_CLASS_COUNT> &frame_counts,
+                               uint64_t partition_count, const MemoryPolicy &memory_policy)
+        : _frame_count{std::accumulate(frame_counts.begin(), frame_counts.end(), uint64_t{0})},
+          _partition_count{partition_count},
+          _partitions(PAGE_SIZE_CLASS_COUNT * partition_count),
+          _magazines_per_size_class(std::max(1u, std::thread::hardware_concurrency())),
+          _magazines(PAGE_SIZE_CLASS_COUNT * _magazines_per_size_class),
+          _next_free(std::make_unique<std::atomic<uint32_t>[]>(_frame_count)),
+          _allocated_frames(std::make_unique<std::atomic<uint64_t>[]>((_frame_count + 63) / 64)),
+          _cooling_frames(std::make_unique<std::atomic<uint64_t>[]>((_frame_count + 63) / 64)) {
+    // The free frame stacks store 32 bit frame indices.
+    assert(_frame_count < STACK_INDEX_MASK);
+    for (uint64_t size_class = 0; size_class < PAGE_SIZE_CLASS_COUNT; ++size_class) {
+        auto &range = _size_classes[size_class];
+        range.offset = _data_size;
+        range.first_index = size_class == 0 ? 0 : _size_classes[size_class - 1].first_index +
+                                                   _size_classes[size_class - 1].frame_count;
+        range.frame_count = frame_counts[size_class];
+        range.partition_size = std::max<uint64_t>(1, (range.frame_count + partition_count - 1) / partition_count);
+        _data_size += range.frame_count * frame_size(static_cast<PageSizeClass>(size_class));
+    }
+    if constexpr (DECOUPLED_FRAMES) {
+        // The page arena starts at the first page boundary behind the frames.
+        _data_size = (_data_size + PAGE_SIZE - 1) / PAGE_SIZE * PAGE_SIZE;
+        for (uint64_t size_class = 0; size_class < PAGE_SIZE_CLASS_COUNT; ++size_class) {
+            auto &range = _size_classes[size_class];
+            range.page_offset = _data_size;
+            _data_size += range.frame_count * page_size(static_cast<PageSizeClass>(size_class));
+        }
+    }
+    _map(memory_policy);
     _init_free_frames();
 }
 
 VolatileRegion::~VolatileRegion() {
-    munmap(frames(), frame_count() * sizeof(BufferFrame));
+    munmap(_data, _mapping_size);
 }
 
-BufferFrame *VolatileRegion::allocate_frame() {
-    // Enough memory frames need to be allocated. Thus, you need to ensure that at least one frame is available before
-    // calling this function. The buffer manager ensures this with the eviction policy.
-    auto value = _free_frames.back();
-    _free_frames.pop_back();
-    return value;
+BufferFrame *VolatileRegion::allocate_frame(PageSizeClass size_class) {
+    auto &magazine = _magazine(size_class);
+    magazine.lock();
+    if (magazine.size.load(std::memory_order_relaxed) == 0) {
+        _refill(magazine, size_class);
+    }
+    BufferFrame *frame = nullptr;
+    if (const auto size = magazine.size.load(std::memory_order_relaxed); size > 0) {
+        frame = magazine.frames[size - 1];
+        magazine.size.store(size - 1, std::memory_order_relaxed);
+    }
+    magazine.unlock();
+
+    // All partitions are empty, but other threads might still cache free frames.
+    if (!frame) {
+        frame = _steal_from_magazines(magazine, size_class);
+    }
+    if (frame) {
+        _set_frame_bit(_allocated_frames.get(), frame, true);
+    }
+    return frame;
 }
 
 void VolatileRegion::free_frame(BufferFrame *frame) {
-    _free_frames.push_back(new(frame) BufferFrame());
+    // Do not re-construct the frame, its latch version must keep increasing.
+    frame->reset();
+    _set_frame_bit(_allocated_frames.get(), frame, false);
+    _set_frame_bit(_cooling_frames.get(), frame, false);
+    auto &magazine = _magazine(_size_class_of(frame));
+    magazine.lock();
+    auto size = magazine.size.load(std::memory_order_relaxed);
+    if (size == MAGAZINE_CAPACITY) {
+        // Return the oldest frames of the magazine to their partitions.
+        for (uint32_t index = 0; index < MAGAZINE_BATCH_SIZE; ++index) {
+            _push_free_frame(magazine.frames[index]);
+        }
+        std::copy(magazine.frames.begin() + MAGAZINE_BATCH_SIZE, magazine.frames.end(), magazine.frames.begin());
+        size -= MAGAZINE_BATCH_SIZE;
+    }
+    magazine.frames[size] = frame;
+    magazine.size.store(size + 1, std::memory_order_relaxed);
+    magazine.unlock();
+}
+
+bool VolatileRegion::uses_explicit_huge_pages() const {
+    return _explicit_huge_pages;
+}
+
+uint64_t VolatileRegion::partition_count() const {
+    return _partition_count;
+}
+
+uint64_t VolatileRegion::partition_of(const BufferFrame *frame) const {
+    const auto &range = _size_classes[static_cast<uint64_t>(_size_class_of(frame))];
+    return (_frame_index(frame) - range.first_index) / range.partition_size;
+}
+
+uint64_t VolatileRegion::home_partition() const {
+    return thread_id() % _partition_count;
+}
+
+BufferFrame *VolatileRegion::frame_at(uint64_t index) {
+    auto size_class = PAGE_SIZE_CLASS_COUNT - 1;
+    while (index < _size_classes[size_class].first_index) {
+        --size_class;
+    }
+    return frame_at(static_cast<PageSizeClass>(size_class), index - _size_classes[size_class].first_index);
+}
+
+BufferFrame *VolatileRegion::frame_at(PageSizeClass size_class, uint64_t index) {
+    const auto &range = _size_classes[static_cast<uint64_t>(size_class)];
+    return reinterpret_cast<BufferFrame *>(_data + range.offset + index * frame_size(size_class));
+}
+
+void VolatileRegion::set_cooling(const BufferFrame *frame, bool cooling) {
+    _set_frame_bit(_cooling_frames.get(), frame, cooling);
+}
+
+BufferFrame *VolatileRegion::next_hot_frame(const BufferFrame *frame) {
+    const auto &range = _size_classes[static_cast<uint64_t>(_size_class_of(frame))];
+    const auto start = _frame_index(frame);
+    const auto end = range.first_index + range.frame_count;
+    if (auto index = _find_hot_frame(start, end); index != end) {
+        return frame_at(index);
+    }
+    if (auto index = _find_hot_frame(range.first_index, start); index != start) {
+        return frame_at(index);
+    }
+    return nullptr;
 }
 
 BufferFrame *VolatileRegion::frames() {
@@ -44,44 +221,315 @@ uint64_t VolatileRegion::frame_count() const {
     return _frame_count;
 }
 
+uint64_t VolatileRegion::frame_count(PageSizeClass size_class) const {
+    return _size_classes[static_cast<uint64_t>(size_class)].frame_count;
+}
+
 uint64_t VolatileRegion::free_frame_count() const {
-    return _free_frames.size();
+    uint64_t free_frames = 0;
+    for (const auto &partition: _partitions) {
+        free_frames += partition.size.load(std::memory_order_relaxed);
+    }
+    for (const auto &magazine: _magazines) {
+        free_frames += magazine.size.load(std::memory_order_relaxed);
+    }
+    return free_frames;
 }
 
-void VolatileRegion::_init_free_frames() {
-    auto frames_begin = frames();
+uint64_t VolatileRegion::free_frame_count(PageSizeClass size_class) const {
+    const auto first_partition = _partitions.begin() + static_cast<int64_t>(size_class) * _partition_count;
+    const auto first_magazine = _magazines.begin() + static_cast<int64_t>(size_class) * _magazines_per_size_class;
+    uint64_t free_frames = 0;
+    for (auto partition = first_partition; partition != first_partition + _partition_count; ++partition) {
+        free_frames += partition->size.load(std::memory_order_relaxed);
+    }
+    for (auto magazine = first_magazine; magazine != first_magazine + _magazines_per_size_class; ++magazine) {
+        free_frames += magazine->size.load(std::memory_order_relaxed);
+    }
+    return free_frames;
+}
+
+void VolatileRegion::_map(const MemoryPolicy &memory_policy) {
+    if (memory_policy.huge_pages == MemoryPolicy::HugePages::EXPLICIT) {
+        // Fails if the hugetlb pool cannot reserve enough huge pages.
+        const auto mapping_size = round_up(std::max<uint64_t>(_data_size, 1), HUGE_PAGE_SIZE);
+        auto *data = mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1,
+                          0);
+        if (data != MAP_FAILED) {
+            _data = static_cast<std::byte *>(data);
+            _mapping_size = mapping_size;
+            _mapping_page_size = HUGE_PAGE_SIZE;
+            _explicit_huge_pages = true;
+        }
+    }
+    if (!_explicit_huge_pages) {
+        _mapping_size = round_up(std::max<uint64_t>(_data_size, 1), SMALL_PAGE_SIZE);
+        auto *data = mmap(nullptr, _mapping_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (data == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+        _data = static_cast<std::byte *>(data);
+        // Whether transparent huge pages are used in the end depends on the system's settings.
+        madvise(_data, _mapping_size,
+                memory_policy.huge_pages == MemoryPolicy::HugePages::NONE ? MADV_NOHUGEPAGE : MADV_HUGEPAGE);
+    }
+
+    // The placement only applies to pages that were not touched yet.
+    _place_on_numa_nodes(memory_policy);
+    if (memory_policy.prefault_threads > 0) {
+        _prefault(memory_policy.prefault_threads);
+    }
+}
+
+void VolatileRegion::_place_on_numa_nodes(const MemoryPolicy &memory_policy) {
+    if (memory_policy.numa_placement == MemoryPolicy::NumaPlacement::DEFAULT) {
+        return;
+    }
+    const auto nodes = memory_policy.numa_nodes.empty() ? numa_nodes_with_memory() : memory_policy.numa_nodes;
+    if (memory_policy.numa_placement == MemoryPolicy::NumaPlacement::INTERLEAVE) {
+        bind_memory(_data, _mapping_size, MPOL_INTERLEAVE, nodes);
+        return;
+    }
 
+    // Partitions rarely end at page boundaries. A page shared by two partitions ends up on the node of the latter.
+    const auto bind_range = [&](uint64_t begin, uint64_t end, uint32_t node) {
+        begin = begin / _mapping_page_size * _mapping_page_size;
+        end = round_up(end, _mapping_page_size);
+        if (begin < end) {
+            bind_memory(_data + begin, end - begin, MPOL_BIND, std::span(&node, 1));
+        }
+    };
+    for (uint64_t size_class = 0; size_class < PAGE_SIZE_CLASS_COUNT; ++size_class) {
+        const auto &range = _size_classes[size_class];
+        const auto page_size_class = static_cast<PageSizeClass>(size_class);
+        for (uint64_t partition = 0; partition * range.partition_size < range.frame_count; ++partition) {
+            const auto first_frame = partition * range.partition_size;
+            const auto end_frame = std::min(first_frame + range.partition_size, range.frame_count);
+            const auto node = nodes[partition % nodes.size()];
+            bind_range(range.offset + first_frame * frame_size(page_size_class),
+                       range.offset + end_frame * frame_size(page_size_class), node);
+            if constexpr (DECOUPLED_FRAMES) {
+                bind_range(range.page_offset + first_frame * page_size(page_size_class),
+                           range.page_offset + end_frame * page_size(page_size_class), node);
+            }
+        }
+    }
+}
+
+void VolatileRegion::_prefault(uint32_t thread_count) {
+    // Every thread writes to one byte of each page of its chunk. Reading would only map the shared zero page.
+    const auto page_count = _mapping_size / _mapping_page_size;
+    auto threads = std::vector<std::thread>{};
+    for (uint64_t thread = 0; thread < thread_count; ++thread) {
+        threads.emplace_back([this, first_page = page_count * thread / thread_count,
+                              end_page = page_count * (thread + 1) / thread_count]() {
+            for (auto page = first_page; page < end_page; ++page) {
+                *reinterpret_cast<volatile std::byte *>(_data + page * _mapping_page_size) = std::byte{0};
+            }
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+}
+
+void VolatileRegion::_init_free_frames() {
     // Initialize all frames. You can use `new (frames_begin + frame_offset) BufferFrame()` to place the buffer frames
     // directly into the pre-allocated storage at memory address `frames_begin + frame_offset`. For more details, search
     // for `Placement new` in cppreference.
-    _free_frames.reserve(frame_count());
+    // Push in descending order, so that each partition hands out its frames in ascending order.
+    for (uint64_t size_class = 0; size_class < PAGE_SIZE_CLASS_COUNT; ++size_class) {
+        const auto page_size_class = static_cast<PageSizeClass>(size_class);
+        for (auto i = _size_classes[size_class].frame_count; i > 0; i--) {
+            auto *frame = new(frame_at(page_size_class, i - 1)) BufferFrame();
+            frame->size_class = page_size_class;
+#if BM_DECOUPLED_FRAMES
+            const auto page_offset = _size_classes[size_class].page_offset + (i - 1) * page_size(page_size_class);
+            frame->page.payload = {_data + page_offset, page_size(page_size_class)};
+#endif
+            _push_free_frame(frame);
+        }
+    }
+}
+
+PageSizeClass VolatileRegion::_size_class_of(const BufferFrame *frame) const {
+    const uint64_t offset = reinterpret_cast<const std::byte *>(frame) - _data;
+    auto size_class = PAGE_SIZE_CLASS_COUNT - 1;
+    while (offset < _size_classes[size_class].offset || _size_classes[size_class].frame_count == 0) {
+        --size_class;
+    }
+    return static_cast<PageSizeClass>(size_class);
+}
+
+uint64_t VolatileRegion::_frame_index(const BufferFrame *frame) const {
+    const auto size_class = _size_class_of(frame);
+    const auto &range = _size_classes[static_cast<uint64_t>(size_class)];
+    const uint64_t offset = reinterpret_cast<const std::byte *>(frame) - _data;
+    return range.first_index + (offset - range.offset) / frame_size(size_class);
+}
+
+VolatileRegion::FreeFramePartition &VolatileRegion::_partition(PageSizeClass size_class, uint64_t partition) {
+    return _partitions[static_cast<uint64_t>(size_class) * _partition_count + partition];
+}
+
+void VolatileRegion::_push_free_frame(BufferFrame *frame) {
+    auto &partition = _partition(_size_class_of(frame), partition_of(frame));
+    const uint64_t index = _frame_index(frame);
+    auto head = partition.head.load(std::memory_order_relaxed);
+    while (true) {
+        _next_free[index].store(head & STACK_INDEX_MASK, std::memory_order_relaxed);
+        const auto tag = (head >> 32) + 1;
+        if (partition.head.compare_exchange_weak(head, (tag << 32) | (index + 1), std::memory_order_release,
+                                                 std::memory_order_relaxed)) {
+            break;
+        }
+    }
+    partition.size.fetch_add(1, std::memory_order_relaxed);
+}
+
+BufferFrame *VolatileRegion::_pop_free_frame(FreeFramePartition &partition) {
+    auto head = partition.head.load(std::memory_order_acquire);
+    while (true) {
+        const auto top = head & STACK_INDEX_MASK;
+        if (top == 0) {
+            return nullptr;
+        }
+        // If another thread pops `top` concurrently, the link might be outdated, but then the tag changed and the
+        // exchange fails.
+        const uint64_t next = _next_free[top - 1].load(std::memory_order_relaxed);
+        const auto tag = (head >> 32) + 1;
+        if (partition.head.compare_exchange_weak(head, (tag << 32) | next, std::memory_order_acquire,
+                                                 std::memory_order_acquire)) {
+            partition.size.fetch_sub(1, std::memory_order_relaxed);
+            return frame_at(top - 1);
+        }
+    }
+}
+
+void VolatileRegion::_refill(Magazine &magazine, PageSizeClass size_class) {
+    std::array<BufferFrame *, MAGAZINE_BATCH_SIZE> batch{};
+    uint32_t batch_size = 0;
+    const auto home = home_partition();
+    for (uint64_t offset = 0; offset < _partition_count && batch_size < MAGAZINE_BATCH_SIZE; ++offset) {
+        auto &partition = _partition(size_class, (home + offset) % _partition_count);
+        while (batch_size < MAGAZINE_BATCH_SIZE) {
+            auto *frame = _pop_free_frame(partition);
+            if (!frame) {
+                break;
+            }
+            batch[batch_size++] = frame;
+        }
+    }
+
+    // The magazine is a stack as well, thus the first popped frame has to end up on top.
+    for (uint32_t index = 0; index < batch_size; ++index) {
+        magazine.frames[index] = batch[batch_size - index - 1];
+    }
+    magazine.size.store(batch_size, std::memory_order_relaxed);
+}
+
+BufferFrame *VolatileRegion::_steal_from_magazines(const Magazine &own_magazine, PageSizeClass size_class) {
+    const auto first_magazine = _magazines.begin() + static_cast<int64_t>(size_class) * _magazines_per_size_class;
+    for (auto magazine = first_magazine; magazine != first_magazine + _magazines_per_size_class; ++magazine) {
+        if (&*magazine == &own_magazine || magazine->size.load(std::memory_order_relaxed) == 0 ||
+            !magazine->try_lock()) {
+            continue;
+        }
+        BufferFrame *frame = nullptr;
+        if (const auto size = magazine->size.load(std::memory_order_relaxed); size > 0) {
+            frame = magazine->frames[size - 1];
+            magazine->size.store(size - 1, std::memory_order_relaxed);
+        }
+        magazine->unlock();
+        if (frame) {
+            return frame;
+        }
+    }
+    return nullptr;
+}
+
+VolatileRegion::Magazine &VolatileRegion::_magazine(PageSizeClass size_class) {
+    return _magazines[static_cast<uint64_t>(size_class) * _magazines_per_size_class +
+                      thread_id() % _magazines_per_size_class];
+}
+
+void VolatileRegion::_set_frame_bit(std::atomic<uint64_t> *bitmap, const BufferFrame *frame, bool value) {
+    const auto index = _frame_index(frame);
+    const auto bit = uint64_t{1} << (index % 64);
+    if (value) {
+        bitmap[index / 64].fetch_or(bit, std::memory_order_relaxed);
+    } else {
+        bitmap[index / 64].fetch_and(~bit, std::memory_order_relaxed);
+    }
+}
+
+uint64_t VolatileRegion::_find_hot_frame(uint64_t begin, uint64_t end) const {
+    for (auto word = begin / 64; word * 64 < end; ++word) {
+        auto hot = _allocated_frames[word].load(std::memory_order_relaxed) &
+                   ~_cooling_frames[word].load(std::memory_order_relaxed);
+        if (word == begin / 64) {
+            hot &= ~uint64_t{0} << (begin % 64);
+        }
+        if (hot != 0) {
+            // Bits beyond `end` belong to the next size class.
+            return std::min(word * 64 + std::countr_zero(hot), end);
+        }
+    }
+    return end;
+}
 
-    for (auto i = frame_count() - 1; i > 0; i--) {
-        auto *bf = new(frames_begin + i) BufferFrame();
-        _free_frames.push_back(bf);
+void VolatileRegion::Magazine::lock() {
+    while (locked.exchange(true, std::memory_order_acquire)) {
+        while (locked.load(std::memory_order_relaxed)) {
+            std::this_thread::yield();
+        }
     }
-    _free_frames.push_back(new(frames_begin) BufferFrame());
+}
+
+bool VolatileRegion::Magazine::try_lock() {
+    return !locked.exchange(true, std::memory_order_acquire);
+}
+
+void VolatileRegion::Magazine::unlock() {
+    locked.store(false, std::memory_order_release);
 }
 
 ///////////////////////////////////////////////////////////
 //// SSD Region
 ///////////////////////////////////////////////////////////
 
-SSDRegion::SSDRegion(const std::filesystem::path &file_path, uint64_t page_count) :
-        _file(open(file_path.c_str(), O_CREAT | O_RDWR | O_DIRECT | O_TRUNC, 0600)),
+SSDRegion::SSDRegion(const std::filesystem::path &file_path, uint64_t page_count, OpenMode mode) :
         _page_count(page_count) {
+    auto map_path = file_path;
+    map_path += ".fsm";
+    _free_space_map_file = open(map_path.c_str(), O_CREAT | O_RDWR, 0600);
+    _reopened = mode == OpenMode::REOPEN && std::filesystem::exists(file_path) && _load_free_space_map();
+
     // open the file at `file_path`. Note, we want to read and write data. If the file already exists, overwrite it. Note,
     // that O_DIRECT is required.
     // open file
     // O_CREAT -> create if not exist
-    // O_TRUNC -> TRUNCATE to 0 if exists
+    // O_TRUNC -> TRUNCATE to 0 if exists (not when reopening)
     // O_RDWR -> READ and WRITE
     // O_DIRECT -> direct disk access -> kernel does not get involved
-    // should contain page_count pages
-    auto dummy_data = (uint8_t *) aligned_alloc(sizeof(Page), page_count * sizeof(Page));
-    pwrite(_file, dummy_data, page_count * sizeof(Page), 0);
+    _file = open(file_path.c_str(), O_CREAT | O_RDWR | O_DIRECT | (_reopened ? 0 : O_TRUNC), 0600);
+    if (!_reopened) {
+        _create_free_space_map();
+    }
+
+    // The file is sparse and grows when pages are allocated (see `_grow_file`).
+    struct stat file_stat{};
+    fstat(_file, &file_stat);
+    _file_page_count = file_stat.st_size / sizeof(Page);
 
-    _init_free_pages();
+    // Allocated pages of a reopened region may contain data, all others are zero.
+    const auto word_count = _allocated_pages.size();
+    _written_pages = std::make_unique<std::atomic<uint64_t>[]>(word_count);
+    for (uint64_t word = 0; word < word_count; ++word) {
+        _written_pages[word].store(_allocated_pages[word], std::memory_order_relaxed);
+    }
+
+    _last_sync.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
 }
 
 uint64_t SSDRegion::page_count() const {
@@ -89,35 +537,342 @@ uint64_t SSDRegion::page_count() const {
 }
 
 uint64_t SSDRegion::free_page_count() const {
-    return _free_pages.size();
+    std::lock_guard lock(_free_pages_mutex);
+    return _page_count - _allocated_page_count;
 }
 
-PageID SSDRegion::allocate_page_id() {
-    PageID freePageId = _free_pages.back();
-    _free_pages.pop_back();
-    return freePageId;
+PageID SSDRegion::allocate_page_id(PageSizeClass size_class) {
+    std::lock_guard lock(_free_pages_mutex);
+    auto &free_pages = _free_pages[static_cast<uint64_t>(size_class)];
+    PageID free_page_id;
+    if (!free_pages.empty()) {
+        free_page_id = free_pages.back();
+        free_pages.pop_back();
+    } else {
+        free_page_id = _find_free_page(size_class);
+        if (free_page_id == INVALID_PAGE_ID) {
+            return INVALID_PAGE_ID;
+        }
+    }
+    _set_allocated(free_page_id, true);
+    _grow_file(page_slot(free_page_id) + page_slot_count(size_class) - 1);
+    return free_page_id;
 }
 
 void SSDRegion::free_page_id(PageID page_id) {
-    _free_pages.push_back(page_id);
+    std::lock_guard lock(_free_pages_mutex);
+    _free_pages[static_cast<uint64_t>(page_size_class(page_id))].push_back(page_id);
+    _set_allocated(page_id, false);
+    // The next owner of the page must not see the old content.
+    const auto slot = page_slot(page_id);
+    _written_pages[slot / 64].fetch_and(~(uint64_t{1} << (slot % 64)), std::memory_order_relaxed);
+}
+
+bool SSDRegion::reopened() const {
+    return _reopened;
 }
 
 SSDRegion::~SSDRegion() {
+    _write_free_space_map();
+    close(_free_space_map_file);
     close(_file);
 }
 
 void SSDRegion::read_page(std::byte *destination, PageID page_id) {
-    pread(_file, destination, sizeof(Page), page_id * sizeof(Page));
+    if (!_is_written(page_id)) {
+        std::memset(destination, 0, _page_size(page_id));
+        return;
+    }
+    pread(_file, destination, _page_size(page_id), _page_offset(page_id));
 }
 
 void SSDRegion::write_page(const std::byte *source, PageID page_id) {
-    pwrite(_file, source, sizeof(Page), page_id * sizeof(Page));
-    fsync(_file);
+    pwrite(_file, source, _page_size(page_id), _page_offset(page_id));
+    _write_call_count.fetch_add(1, std::memory_order_relaxed);
+    _mark_written(page_id);
+    _writes_completed(1);
+}
+
+void SSDRegion::read_pages(std::span<const PageIO> requests) {
+    for (const auto &request: requests) {
+        read_page(request.buffer, request.page_id);
+    }
+}
+
+void SSDRegion::write_pages(std::span<const PageIO> requests) {
+    auto sorted = std::vector<PageIO>(requests.begin(), requests.end());
+    std::sort(sorted.begin(), sorted.end(), [](const PageIO &left, const PageIO &right) {
+        return _page_offset(left.page_id) < _page_offset(right.page_id);
+    });
+
+    // Write each run of adjacent pages with one call.
+    auto iovecs = std::vector<iovec>{};
+    for (uint64_t begin = 0; begin < sorted.size();) {
+        const auto offset = _page_offset(sorted[begin].page_id);
+        auto end_offset = offset;
+        auto end = begin;
+        iovecs.clear();
+        while (end < sorted.size() && iovecs.size() < IOV_MAX && _page_offset(sorted[end].page_id) == end_offset) {
+            const auto size = _page_size(sorted[end].page_id);
+            iovecs.push_back({sorted[end].buffer, size});
+            end_offset += size;
+            ++end;
+        }
+        _write_vectored(iovecs, offset);
+        for (; begin < end; ++begin) {
+            _mark_written(sorted[begin].page_id);
+        }
+    }
+    _writes_completed(requests.size());
+}
+
+void SSDRegion::sync() {
+    _sync_data();
+    _write_free_space_map();
+}
+
+void SSDRegion::_sync_data() {
+    const auto target = _completed_writes.load(std::memory_order_acquire);
+    std::lock_guard lock(_sync_mutex);
+    if (_synced_writes.load(std::memory_order_relaxed) >= target) {
+        // A flush that started after our writes completed already covered them.
+        return;
+    }
+
+    // Everything completed until now is covered by this flush, including writes of threads waiting for the lock.
+    const auto covered = _completed_writes.load(std::memory_order_acquire);
+    // The file size does not change after construction, thus flushing the data is sufficient.
+    fdatasync(_file);
+    _synced_writes.store(covered, std::memory_order_release);
+    _last_sync.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+    _sync_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+void SSDRegion::set_sync_policy(SyncPolicy policy) {
+    _sync_policy = policy;
+}
+
+uint64_t SSDRegion::write_call_count() const {
+    return _write_call_count.load(std::memory_order_relaxed);
+}
+
+uint64_t SSDRegion::sync_count() const {
+    return _sync_count.load(std::memory_order_relaxed);
+}
+
+void SSDRegion::_write_vectored(std::span<iovec> iovecs, uint64_t offset) {
+    while (!iovecs.empty()) {
+        const auto written = pwritev(_file, iovecs.data(), static_cast<int>(iovecs.size()), static_cast<off_t>(offset));
+        _write_call_count.fetch_add(1, std::memory_order_relaxed);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        // Continue a short write after the last byte written.
+        offset += written;
+        for (auto remaining = static_cast<uint64_t>(written); remaining > 0 && !iovecs.empty();) {
+            if (remaining >= iovecs.front().iov_len) {
+                remaining -= iovecs.front().iov_len;
+                iovecs = iovecs.subspan(1);
+            } else {
+                iovecs.front().iov_base = static_cast<std::byte *>(iovecs.front().iov_base) + remaining;
+                iovecs.front().iov_len -= remaining;
+                remaining = 0;
+            }
+        }
+    }
+}
+
+void SSDRegion::_writes_completed(uint64_t count) {
+    const auto completed = _completed_writes.fetch_add(count, std::memory_order_acq_rel) + count;
+    switch (_sync_policy.mode) {
+        case SyncPolicy::Mode::ALWAYS:
+            _sync_data();
+            break;
+        case SyncPolicy::Mode::EVERY_N_WRITES:
+            if (completed - _synced_writes.load(std::memory_order_acquire) >= _sync_policy.write_count) {
+                _sync_data();
+            }
+            break;
+        case SyncPolicy::Mode::INTERVAL: {
+            const auto last_sync = std::chrono::steady_clock::duration{_last_sync.load(std::memory_order_relaxed)};
+            if (std::chrono::steady_clock::now().time_since_epoch() - last_sync >= _sync_policy.interval) {
+                _sync_data();
+            }
+            break;
+        }
+    }
+}
+
+namespace {
+
+// Header stored in the first block of the free space map.
+struct FreeSpaceMapHeader {
+    uint64_t magic;
+    uint64_t page_count;
+    uint64_t page_size;
+};
+
+constexpr uint64_t FREE_SPACE_MAP_MAGIC = 0x6c62'6d2d'6673'6d01;
+
+}  // namespace
+
+bool SSDRegion::_load_free_space_map() {
+    FreeSpaceMapHeader header{};
+    if (pread(_free_space_map_file, &header, sizeof(header), 0) != sizeof(header) ||
+        header.magic != FREE_SPACE_MAP_MAGIC || header.page_count != _page_count || header.page_size != PAGE_SIZE) {
+        return false;
+    }
+
+    _allocated_pages.assign((_page_count + 63) / 64, 0);
+    const auto bitmap_size = _allocated_pages.size() * sizeof(uint64_t);
+    if (pread(_free_space_map_file, _allocated_pages.data(), bitmap_size, FREE_SPACE_MAP_BLOCK_SIZE) !=
+        static_cast<ssize_t>(bitmap_size)) {
+        return false;
+    }
+    _allocated_page_count = 0;
+    for (auto word : _allocated_pages) {
+        _allocated_page_count += std::popcount(word);
+    }
+    _dirty_free_space_map_blocks.assign(
+            (_page_count + PAGES_PER_FREE_SPACE_MAP_BLOCK - 1) / PAGES_PER_FREE_SPACE_MAP_BLOCK, false);
+    return true;
+}
+
+void SSDRegion::_create_free_space_map() {
+    _allocated_pages.assign((_page_count + 63) / 64, 0);
+    _allocated_page_count = 0;
+    _dirty_free_space_map_blocks.assign(
+            (_page_count + PAGES_PER_FREE_SPACE_MAP_BLOCK - 1) / PAGES_PER_FREE_SPACE_MAP_BLOCK, false);
+
+    // A truncated file reads as zeros, i.e., all pages are free.
+    ftruncate(_free_space_map_file, 0);
+    ftruncate(_free_space_map_file, FREE_SPACE_MAP_BLOCK_SIZE * (1 + _dirty_free_space_map_blocks.size()));
+    const FreeSpaceMapHeader header{FREE_SPACE_MAP_MAGIC, _page_count, PAGE_SIZE};
+    pwrite(_free_space_map_file, &header, sizeof(header), 0);
+    fdatasync(_free_space_map_file);
+}
+
+void SSDRegion::_write_free_space_map() {
+    {
+        std::lock_guard lock(_free_pages_mutex);
+        if (!_free_space_map_dirty) {
+            return;
+        }
+        constexpr auto words_per_block = FREE_SPACE_MAP_BLOCK_SIZE / sizeof(uint64_t);
+        for (uint64_t block = 0; block < _dirty_free_space_map_blocks.size(); ++block) {
+            if (!_dirty_free_space_map_blocks[block]) {
+                continue;
+            }
+            const auto first_word = block * words_per_block;
+            const auto word_count = std::min<uint64_t>(words_per_block, _allocated_pages.size() - first_word);
+            pwrite(_free_space_map_file, _allocated_pages.data() + first_word, word_count * sizeof(uint64_t),
+                   FREE_SPACE_MAP_BLOCK_SIZE * (1 + block));
+            _dirty_free_space_map_blocks[block] = false;
+        }
+        _free_space_map_dirty = false;
+    }
+    fdatasync(_free_space_map_file);
+}
+
+PageID SSDRegion::_find_free_page(PageSizeClass size_class) {
+    // A page occupies a run of free slots that is aligned to its size. Since runs are at most 64 slots long, they never
+    // span multiple words of the bitmap.
+    const auto slot_count = page_slot_count(size_class);
+    auto run_starts = ~uint64_t{0};
+    if (slot_count < 64) {
+        run_starts = 0;
+        for (uint64_t bit = 0; bit < 64; bit += slot_count) {
+            run_starts |= uint64_t{1} << bit;
+        }
+    } else {
+        run_starts = 1;
+    }
+
+    const auto word_count = _allocated_pages.size();
+    for (uint64_t scanned = 0; scanned <= word_count; ++scanned) {
+        const auto word_index = (_allocation_cursor / 64 + scanned) % word_count;
+        auto free_bits = ~_allocated_pages[word_index];
+        if (word_index == word_count - 1 && _page_count % 64 != 0) {
+            // Ignore the bits beyond the last page.
+            free_bits &= (uint64_t{1} << (_page_count % 64)) - 1;
+        }
+        // Afterwards, bit i is set if the slots [i, i + slot_count) are free.
+        for (uint64_t shift = 1; shift < slot_count; shift <<= 1) {
+            free_bits &= free_bits >> shift;
+        }
+        free_bits &= run_starts;
+        if (free_bits != 0) {
+            const PageID slot = word_index * 64 + std::countr_zero(free_bits);
+            _allocation_cursor = (slot + slot_count) % _page_count;
+            return make_page_id(slot, size_class);
+        }
+    }
+    return INVALID_PAGE_ID;
+}
+
+std::vector<PageIO> SSDRegion::_requests_to_read(std::span<const PageIO> requests) {
+    auto to_read = std::vector<PageIO>{};
+    to_read.reserve(requests.size());
+    for (const auto &request: requests) {
+        if (_is_written(request.page_id)) {
+            to_read.push_back(request);
+        } else {
+            std::memset(request.buffer, 0, _page_size(request.page_id));
+        }
+    }
+    return to_read;
+}
+
+bool SSDRegion::_is_written(PageID page_id) const {
+    // Only the first slot of a page is tracked.
+    const auto slot = page_slot(page_id);
+    return (_written_pages[slot / 64].load(std::memory_order_acquire) >> (slot % 64)) & 1;
+}
+
+void SSDRegion::_mark_written(PageID page_id) {
+    const auto slot = page_slot(page_id);
+    _written_pages[slot / 64].fetch_or(uint64_t{1} << (slot % 64), std::memory_order_release);
+}
+
+uint64_t SSDRegion::_page_offset(PageID page_id) {
+    return page_slot(page_id) * sizeof(Page);
+}
+
+uint64_t SSDRegion::_page_size(PageID page_id) {
+    return page_size(page_size_class(page_id));
+}
+
+void SSDRegion::_grow_file(PageID slot) {
+    if (slot < _file_page_count) {
+        return;
+    }
+    const auto extent_count = (slot - _file_page_count) / FILE_EXTENT_PAGE_COUNT + 1;
+    const auto new_page_count = std::min(_page_count, _file_page_count + extent_count * FILE_EXTENT_PAGE_COUNT);
+    // Reserve the space of the extent, so that writes do not fail with ENOSPC later. File systems without fallocate
+    // support only get a sparse file.
+    const auto offset = _file_page_count * sizeof(Page);
+    const auto length = (new_page_count - _file_page_count) * sizeof(Page);
+    if (fallocate(_file, 0, static_cast<off_t>(offset), static_cast<off_t>(length)) != 0) {
+        ftruncate(_file, static_cast<off_t>(new_page_count * sizeof(Page)));
+    }
+    _file_page_count = new_page_count;
 }
 
-void SSDRegion::_init_free_pages() {
-    for (PageID i = _page_count - 1; i > 0; i--) {
-        _free_pages.push_back(i);
+void SSDRegion::_set_allocated(PageID page_id, bool allocated) {
+    const auto slot = page_slot(page_id);
+    const auto slot_count = page_slot_count(page_size_class(page_id));
+    const auto mask = (slot_count == 64 ? ~uint64_t{0} : (uint64_t{1} << slot_count) - 1) << (slot % 64);
+    auto &word = _allocated_pages[slot / 64];
+    if (allocated) {
+        word |= mask;
+        _allocated_page_count += slot_count;
+    } else {
+        word &= ~mask;
+        _allocated_page_count -= slot_count;
     }
-    _free_pages.push_back(0);
+    _dirty_free_space_map_blocks[slot / PAGES_PER_FREE_SPACE_MAP_BLOCK] = true;
+    _free_space_map_dirty = true;
 }
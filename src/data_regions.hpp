@@ -1,7 +1,15 @@
 #pragma once
 
+#include <sys/uio.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <filesystem>
+#include <memory>
+#include <mutex>
+#include <span>
 #include <stack>
 #include <vector>
 
@@ -9,6 +17,23 @@
 
 class BufferManager;
 
+// Determines how the memory of a volatile region is mapped. (1) Huge pages: TRANSPARENT advises the kernel to back the
+// region with transparent huge pages, EXPLICIT maps it from the hugetlb pool (MAP_HUGETLB) and falls back to TRANSPARENT
+// if the pool has too few huge pages. (2) Pre-faulting: `prefault_threads` threads touch every page of the region in
+// the constructor, so that the first access of a frame does not pay a page fault. (3) NUMA placement: INTERLEAVE
+// spreads the pages over the nodes round-robin, PARTITIONED binds the frames (and pages) of partition p to node
+// `numa_nodes[p % numa_nodes.size()]`. Without `numa_nodes`, all nodes with memory are used. All policies are best
+// effort, i.e., the region is usable if the kernel rejects them.
+struct MemoryPolicy {
+    enum class HugePages { NONE, TRANSPARENT, EXPLICIT };
+    enum class NumaPlacement { DEFAULT, INTERLEAVE, PARTITIONED };
+
+    HugePages huge_pages = HugePages::TRANSPARENT;
+    uint32_t prefault_threads = 0;
+    NumaPlacement numa_placement = NumaPlacement::DEFAULT;
+    std::vector<uint32_t> numa_nodes{};
+};
+
 class VolatileRegion {
 public:
     // Allocates memory for volatile BufferFrames, i.e., this memory range holds all data that you will read and modify
@@ -17,36 +42,108 @@ public:
     // implementation of the utility functions data_begin() and data_end() (see below), the member variables _data needs
     // to store the start address of the allocated memory region. If you do not store the start address pointer in _data,
     // you need to modify data_begin() and data_end() accordingly.
-    explicit VolatileRegion(uint64_t frame_count);
+    //
+    // The frames are split into `partition_count` partitions of consecutive frames, each with its own lock-free stack of
+    // free frames. On top, every thread has a small cache (magazine) of free frames, so that most allocations and frees
+    // only touch the thread's own magazine. Magazines are refilled in batches from the thread's home partition and
+    // threads steal from other partitions and magazines if theirs run dry. With a single partition and thread, frames
+    // are allocated in ascending order and freed frames are reused first. All frames are of the 4 KiB size class. The
+    // memory is mapped according to `memory_policy` (see `MemoryPolicy`).
+    explicit VolatileRegion(uint64_t frame_count, uint64_t partition_count = 1, const MemoryPolicy &memory_policy = {});
+
+    // Allocates `frame_counts[c]` frames of the size class c (see `PageSizeClass`). The frames of each size class are
+    // stored consecutively, starting with the smallest class, and every size class has its own partitions and
+    // magazines. A frame of class c takes `frame_size(c)` bytes, i.e., its page extends beyond the BufferFrame struct.
+    // With decoupled frames (see BM_DECOUPLED_FRAMES), all frames are stored in front of a page-aligned arena that holds
+    // the pages of all size classes in the same order.
+    explicit VolatileRegion(const std::array<uint64_t, PAGE_SIZE_CLASS_COUNT> &frame_counts,
+                            uint64_t partition_count = 1, const MemoryPolicy &memory_policy = {});
 
     // Free all acquired resources.
     ~VolatileRegion();
 
-    // Create a new frame within the volatile region to use. The function assumes that at least one free frame is
-    // available. Thus, the caller has to make sure that at least one frame is free.
-    BufferFrame *allocate_frame();
+    // Create a new frame of the given size class within the volatile region to use. Returns nullptr if no frame of the
+    // size class is free. Thus, the caller has to make sure that at least one frame is free.
+    BufferFrame *allocate_frame(PageSizeClass size_class = PageSizeClass::SIZE_4K);
 
     // Frees the memory of the volatile `frame`. Thus, the frame's memory region can be reused for other frame allocations
     // afterwards. Note that modified pages stored in a buffer frame should be flushed before calling this function.
-    // Otherwise, the data changes are lost.
+    // Otherwise, the data changes are lost. The frame is cached in the calling thread's magazine; if the magazine is
+    // full, frames are returned to the partitions they belong to.
     void free_frame(BufferFrame *frame);
 
+    // Returns whether the region is backed by the hugetlb pool, i.e., `MemoryPolicy::HugePages::EXPLICIT` did not fall
+    // back to transparent huge pages.
+    bool uses_explicit_huge_pages() const;
+
+    // Returns the number of partitions (per size class).
+    uint64_t partition_count() const;
+
+    // Returns the partition the frame belongs to within its size class. This is determined by the frame's address only.
+    uint64_t partition_of(const BufferFrame *frame) const;
+
+    // Returns the home partition of the calling thread. Threads are assigned to partitions round-robin.
+    uint64_t home_partition() const;
+
+    // Returns the frame with the given index. Indices are consecutive over all size classes, starting with the smallest.
+    BufferFrame *frame_at(uint64_t index);
+
+    // Returns the frame with the given index within its size class.
+    BufferFrame *frame_at(PageSizeClass size_class, uint64_t index);
+
+    // Marks the frame as cooling or hot in the occupancy bitmap (see `next_hot_frame`). Allocating a frame marks it hot,
+    // freeing it marks it free. The buffer manager marks frames cooling while they are in its cooling stage.
+    void set_cooling(const BufferFrame *frame, bool cooling);
+
+    // Returns the first hot frame (allocated and not cooling) at or after `frame` within the frame's size class, wrapping
+    // around at the end of the size class, or nullptr if no frame of the size class is hot. The region keeps one bit per
+    // frame for being allocated and one for cooling, thus the search scans 64 frames per word without touching them and
+    // its cost does not depend on how many frames are free or cooling. The bits are updated without synchronizing with
+    // the frame's latch, thus the result is a hint that has to be re-checked while holding the latch.
+    BufferFrame *next_hot_frame(const BufferFrame *frame);
+
+    // Returns the distance in bytes between consecutive frames of the size class.
+    static constexpr uint64_t frame_size(PageSizeClass size_class) {
+        if constexpr (DECOUPLED_FRAMES) {
+            return sizeof(BufferFrame);
+        } else {
+            return sizeof(BufferFrame) + page_size(size_class) - PAGE_SIZE;
+        }
+    }
+
+    // Returns the number of bytes a frame of the size class takes in the region including its page, e.g., to derive the
+    // number of frames that fit into a memory budget.
+    static constexpr uint64_t frame_memory_size(PageSizeClass size_class) {
+        if constexpr (DECOUPLED_FRAMES) {
+            return sizeof(BufferFrame) + page_size(size_class);
+        } else {
+            return frame_size(size_class);
+        }
+    }
+
     // Returns the pointer to the volatile data/memory region as a BufferFrame*. This allows accessing all
-    // of the volatile region's frames.
+    // of the volatile region's frames of the smallest size class with frames.
     BufferFrame *frames();
 
     // Returns the total number of volatile data region's frames.
     uint64_t frame_count() const;
 
-    // Returns the number of free frames in the volatile data region.
+    // Returns the number of frames of the size class.
+    uint64_t frame_count(PageSizeClass size_class) const;
+
+    // Returns the number of free frames in the volatile data region, including the frames cached in magazines. Under
+    // concurrent allocations, the result is a snapshot.
     uint64_t free_frame_count() const;
 
+    // Returns the number of free frames of the size class (see `free_frame_count`).
+    uint64_t free_frame_count(PageSizeClass size_class) const;
+
     // Helper methods for tests. Do not modify!
     bool address_in_range(const void *addr) const { return data_begin() <= addr && addr < data_end(); }
 
     std::byte *data_begin() const { return _data; }
 
-    std::byte *data_end() const { return _data + _frame_count * sizeof(BufferFrame); }
+    std::byte *data_end() const { return _data + _data_size; }
 
     // Delete move and copy
     VolatileRegion(const VolatileRegion &) = delete;
@@ -58,41 +155,214 @@ public:
     VolatileRegion &operator=(VolatileRegion &&) = delete;
 
 private:
+    // Lock-free (Treiber) stack of free frames. The head stores the index of the top frame plus one (0 if the stack is
+    // empty) in the lower 32 bits and a tag in the upper 32 bits, which is incremented with every change to avoid the ABA
+    // problem. The links are stored in `_next_free`, so the stack does not touch the frames themselves. Cache line
+    // aligned to avoid false sharing between partitions.
+    struct alignas(64) FreeFramePartition {
+        std::atomic<uint64_t> head{0};
+        std::atomic<uint64_t> size{0};
+    };
+
+    // Per-thread cache of free frames. A magazine is protected by a spin lock, which is only contended if more threads
+    // than magazines exist or a thread steals from another thread's magazine.
+    static constexpr uint32_t MAGAZINE_CAPACITY = 16;
+    // Number of frames moved between a magazine and the partitions at once.
+    static constexpr uint32_t MAGAZINE_BATCH_SIZE = MAGAZINE_CAPACITY / 2;
+
+    struct alignas(64) Magazine {
+        std::atomic<bool> locked{false};
+        std::atomic<uint32_t> size{0};
+        std::array<BufferFrame *, MAGAZINE_CAPACITY> frames{};
+
+        void lock();
+        bool try_lock();
+        void unlock();
+    };
+
+    // Consecutive range of the frames of one size class.
+    struct SizeClassRange {
+        // Offset of the first frame in the region.
+        uint64_t offset = 0;
+        // Offset of the first page in the region. Only used with decoupled frames.
+        uint64_t page_offset = 0;
+        // Index of the first frame (see `frame_at`).
+        uint64_t first_index = 0;
+        uint64_t frame_count = 0;
+        // Number of consecutive frames per partition.
+        uint64_t partition_size = 1;
+    };
+
+    // Maps the region's memory and applies the memory policy.
+    void _map(const MemoryPolicy &memory_policy);
+
+    // Applies the NUMA placement of the memory policy. Expects the memory not to be touched yet.
+    void _place_on_numa_nodes(const MemoryPolicy &memory_policy);
+
+    // Touches every page of the region with the given number of threads.
+    void _prefault(uint32_t thread_count);
+
     void _init_free_frames();
 
+    // Returns the size class of the frame. This is determined by the frame's address only.
+    PageSizeClass _size_class_of(const BufferFrame *frame) const;
+
+    // Returns the index of the frame (see `frame_at`).
+    uint64_t _frame_index(const BufferFrame *frame) const;
+
+    // Returns the free frame stack of a partition of the size class.
+    FreeFramePartition &_partition(PageSizeClass size_class, uint64_t partition);
+
+    // Pushes the frame on the stack of its partition.
+    void _push_free_frame(BufferFrame *frame);
+
+    // Pops a frame from the partition's stack or returns nullptr if it is empty.
+    BufferFrame *_pop_free_frame(FreeFramePartition &partition);
+
+    // Moves up to MAGAZINE_BATCH_SIZE frames of the size class from the partitions to the magazine, starting with the
+    // home partition.
+    void _refill(Magazine &magazine, PageSizeClass size_class);
+
+    // Takes a frame out of another thread's magazine of the size class. Returns nullptr if all magazines are empty or
+    // locked.
+    BufferFrame *_steal_from_magazines(const Magazine &own_magazine, PageSizeClass size_class);
+
+    // Returns the calling thread's magazine of the size class.
+    Magazine &_magazine(PageSizeClass size_class);
+
+    // Sets or clears the frame's bit in the bitmap.
+    void _set_frame_bit(std::atomic<uint64_t> *bitmap, const BufferFrame *frame, bool value);
+
+    // Returns the index of the first hot frame in [begin, end), or `end` if none of them is hot.
+    uint64_t _find_hot_frame(uint64_t begin, uint64_t end) const;
+
     std::byte *_data = nullptr;
+    uint64_t _data_size = 0;
+    // Size of the mapping, rounded up to whole (huge) pages.
+    uint64_t _mapping_size = 0;
+    // Size of the pages backing the mapping.
+    uint64_t _mapping_page_size = 4 * KiB;
+    bool _explicit_huge_pages = false;
     const uint64_t _frame_count;
-    uint64_t _free_frame_count;
-    std::vector<BufferFrame *> _free_frames{};
+    std::array<SizeClassRange, PAGE_SIZE_CLASS_COUNT> _size_classes{};
+    uint64_t _partition_count;
+    // Free frame stacks, `_partition_count` per size class.
+    std::vector<FreeFramePartition> _partitions;
+    // Magazines, `_magazines_per_size_class` per size class.
+    uint64_t _magazines_per_size_class;
+    std::vector<Magazine> _magazines;
+    // Links of the free frame stacks: index of the next free frame plus one, 0 terminates a stack.
+    std::unique_ptr<std::atomic<uint32_t>[]> _next_free;
+    // Occupancy bitmap, one bit per frame index: frames that are allocated and frames that are cooling. A frame is hot
+    // if it is allocated and not cooling.
+    std::unique_ptr<std::atomic<uint64_t>[]> _allocated_frames;
+    std::unique_ptr<std::atomic<uint64_t>[]> _cooling_frames;
+};
+
+// A single page-sized I/O request for the batched SSDRegion interface. For reads, `buffer` is the destination; for
+// writes, it is the source.
+struct PageIO {
+    std::byte *buffer;
+    PageID page_id;
+};
+
+// Determines when written pages are made durable. Writes themselves never flush; SSDRegion::sync() is the flush
+// barrier. (1) ALWAYS: every write waits for a flush covering it, (2) EVERY_N_WRITES: a flush is issued after
+// `write_count` writes, (3) INTERVAL: the first write after `interval` elapsed since the last flush issues one. With (2)
+// and (3), a crash can lose writes that were not yet flushed. Concurrent flushes are grouped, i.e., threads arriving
+// while a flush is running share the next one instead of each issuing their own.
+struct SyncPolicy {
+    enum class Mode { ALWAYS, EVERY_N_WRITES, INTERVAL };
+
+    static SyncPolicy always() { return {Mode::ALWAYS, 1, {}}; }
+
+    static SyncPolicy every_n_writes(uint64_t write_count) { return {Mode::EVERY_N_WRITES, write_count, {}}; }
+
+    static SyncPolicy every(std::chrono::microseconds interval) { return {Mode::INTERVAL, 0, interval}; }
+
+    Mode mode = Mode::ALWAYS;
+    uint64_t write_count = 1;
+    std::chrono::microseconds interval{};
 };
 
 // This class represents the data on disk. Pages are logically mapped from 0 to n via their page id. So page 0 starts
 // at offset 0, page 1 starts at 1 * PAGE_SIZE, page 2 starts at 2 * PAGE_SIZE, and page k starts at k * PAGE_SIZE.
+//
+// Which page IDs are allocated is tracked in a bitmap that is persisted next to the data file (`<file_path>.fsm`). The
+// bitmap's first 4 KiB block stores a header, each following block covers 32768 pages. Only blocks that changed since
+// the last `sync()` are written back, thus an existing region can be reopened without rewriting the data file.
+//
+// The data file starts as an empty sparse file and is grown in extents of `FILE_EXTENT_PAGE_COUNT` pages once
+// `allocate_page_id` hands out a page beyond its end. Pages that were never written since they were allocated read as
+// zeros without any I/O.
 class SSDRegion {
 public:
-    // Opens the file at `file_path`. Overwrite an existing file and resize it to contain `page_count` pages.
-    SSDRegion(const std::filesystem::path &file_path, uint64_t page_count);
-
-    // Free all acquired resources.
-    ~SSDRegion();
-
-    // Returns the next available page ID. Page IDs are ascending starting with 0. However, page IDs can be freed, when
-    // they are not required anymore. If page IDs get freed, this function returns the most recently freed page id.
-    PageID allocate_page_id();
+    enum class OpenMode {
+        // Overwrite an existing file.
+        CREATE,
+        // Keep the data of an existing file and load its free space map. If the file or its free space map does not
+        // exist or was created with a different page count or page size, the region is created instead.
+        REOPEN
+    };
+
+    // Number of pages by which the data file grows at once.
+    static constexpr uint64_t FILE_EXTENT_PAGE_COUNT = 1024;
+
+    // Opens the file at `file_path`. Overwrite an existing file, unless an existing region is reopened (see
+    // `OpenMode`). The region holds up to `page_count` pages, but the file only grows when pages are allocated.
+    SSDRegion(const std::filesystem::path &file_path, uint64_t page_count, OpenMode mode = OpenMode::CREATE);
+
+    // Writes back the free space map and frees all acquired resources.
+    virtual ~SSDRegion();
+
+    // Returns the next available page ID of the size class. Page IDs are ascending starting with 0. However, page IDs can
+    // be freed, when they are not required anymore. If page IDs of the size class get freed, this function returns the
+    // most recently freed page id. After reopening a region, the lowest free page IDs are returned first. Returns
+    // INVALID_PAGE_ID if no run of free slots is large enough. Pages of larger size classes occupy multiple slots (see
+    // `PageSizeClass`), and the size class is part of their ID.
+    PageID allocate_page_id(PageSizeClass size_class = PageSizeClass::SIZE_4K);
 
     // Frees the given page_id so that it is available for allocation (see `allocate_page_id`).
     void free_page_id(PageID page_id);
 
-    // Reads an entire page (= PAGE_SIZE) with `page_id` from the backing file into `destination`.
-    void read_page(std::byte *destination, PageID page_id);
+    // Reads an entire page (= the page size of its size class) with `page_id` from the backing file into `destination`. A
+    // page that was never written is zeroed instead.
+    virtual void read_page(std::byte *destination, PageID page_id);
+
+    // Writes an entire page (= the page size of its size class) with `page_id` from `source` to the backing file. Whether the write is
+    // durable when this function returns depends on the sync policy (see `SyncPolicy`).
+    virtual void write_page(const std::byte *source, PageID page_id);
+
+    // Reads all requested pages and returns once every read completed. This implementation issues one blocking read
+    // after another; asynchronous backends keep multiple requests in flight.
+    virtual void read_pages(std::span<const PageIO> requests);
+
+    // Writes all requested pages and returns once every write completed (see `read_pages`). The sync policy is applied
+    // once for the whole batch. Requests are sorted by their offset, and runs of adjacent pages are written with a
+    // single vectored write.
+    virtual void write_pages(std::span<const PageIO> requests);
+
+    // Flush barrier: once this function returns, all writes that completed before the call are durable. If another
+    // thread's flush started after our writes completed, it covers them and we do not flush again. Also writes back the
+    // changed blocks of the free space map.
+    void sync();
 
-    // Writes an entire page (= PAGE_SIZE) with `page_id` from `source` to the backing file.
-    void write_page(const std::byte *source, PageID page_id);
+    // Returns whether an existing region was reopened, i.e., the data and the free space map were kept.
+    bool reopened() const;
 
-    // Returns the total number of the SSD data region's pages (including unwritten ones).
+    // Sets the policy that decides when writes are flushed. The default policy is `SyncPolicy::always()`.
+    void set_sync_policy(SyncPolicy policy);
+
+    // Returns the number of flushes (fdatasync calls) of the data file issued so far.
+    uint64_t sync_count() const;
+
+    // Returns the number of blocking write calls (pwrite or pwritev) of pages issued so far.
+    uint64_t write_call_count() const;
+
+    // Returns the total number of the SSD data region's PAGE_SIZE slots (including unwritten ones).
     uint64_t page_count() const;
 
-    // Returns the number of available, i.e., currently not allocated, pages in the SSD data region.
+    // Returns the number of available, i.e., currently not allocated, PAGE_SIZE slots in the SSD data region.
     uint64_t free_page_count() const;
 
     // Delete move and copy
@@ -104,10 +374,88 @@ public:
 
     SSDRegion &operator=(SSDRegion &&) = delete;
 
+protected:
+    // Records `count` completed writes and flushes them if the sync policy demands it. Backends call this after their
+    // writes completed.
+    void _writes_completed(uint64_t count);
+
+    // Zeroes the buffers of requests for pages that were never written and returns the remaining requests, which have to
+    // be read from the file.
+    std::vector<PageIO> _requests_to_read(std::span<const PageIO> requests);
+
+    // Returns whether the page was written since it was allocated.
+    bool _is_written(PageID page_id) const;
+
+    // Remembers that the page was written, so that subsequent reads access the file.
+    void _mark_written(PageID page_id);
+
+    // Returns the offset of the page in the file.
+    static uint64_t _page_offset(PageID page_id);
+
+    // Returns the size of the page in bytes.
+    static uint64_t _page_size(PageID page_id);
+
+    int32_t _file = -1;
+
 private:
-    void _init_free_pages();
+    // Size of the free space map's header and bitmap blocks.
+    static constexpr uint64_t FREE_SPACE_MAP_BLOCK_SIZE = 4 * KiB;
+    static constexpr uint64_t PAGES_PER_FREE_SPACE_MAP_BLOCK = FREE_SPACE_MAP_BLOCK_SIZE * 8;
+
+    // Loads the free space map of an existing region. Returns false if it does not match this region.
+    bool _load_free_space_map();
+
+    // Creates an empty free space map.
+    void _create_free_space_map();
+
+    // Writes the changed blocks of the free space map and flushes them.
+    void _write_free_space_map();
+
+    // Flushes the data file unless a concurrent flush covered all completed writes (see `sync`).
+    void _sync_data();
+
+    // Writes the buffers to the data file starting at `offset`, continuing short writes. Modifies `iovecs`.
+    void _write_vectored(std::span<iovec> iovecs, uint64_t offset);
+
+    // Returns the ID of the first free page of the size class starting at the allocation cursor. Expects
+    // `_free_pages_mutex` to be held.
+    PageID _find_free_page(PageSizeClass size_class);
+
+    // Updates the allocation bits of the page's slots. Expects `_free_pages_mutex` to be held.
+    void _set_allocated(PageID page_id, bool allocated);
+
+    // Grows the data file by whole extents until it contains `slot`. Expects `_free_pages_mutex` to be held.
+    void _grow_file(PageID slot);
 
-    const int32_t _file;
     uint64_t _page_count;
-    std::vector<PageID> _free_pages{};
+    bool _reopened = false;
+
+    // One bit per PAGE_SIZE slot, set if the slot is allocated.
+    std::vector<uint64_t> _allocated_pages{};
+    uint64_t _allocated_page_count = 0;
+    // Pages freed since the region was opened, per size class. They are reused before searching the bitmap.
+    std::array<std::vector<PageID>, PAGE_SIZE_CLASS_COUNT> _free_pages{};
+    // Position in the bitmap at which the search for free pages continues.
+    PageID _allocation_cursor = 0;
+    // One flag per bitmap block that changed since it was written back.
+    std::vector<bool> _dirty_free_space_map_blocks{};
+    bool _free_space_map_dirty = false;
+    mutable std::mutex _free_pages_mutex;
+
+    int32_t _free_space_map_file = -1;
+
+    // Number of pages the data file currently has space for. Only grows while `_free_pages_mutex` is held.
+    uint64_t _file_page_count = 0;
+    // One bit per slot, set if the page starting at the slot was written since it was allocated.
+    std::unique_ptr<std::atomic<uint64_t>[]> _written_pages;
+
+    SyncPolicy _sync_policy{};
+    // Number of completed writes and the number of writes known to be durable. Both only increase.
+    std::atomic<uint64_t> _completed_writes{0};
+    std::atomic<uint64_t> _synced_writes{0};
+    std::atomic<uint64_t> _sync_count{0};
+    std::atomic<uint64_t> _write_call_count{0};
+    std::atomic<std::chrono::steady_clock::rep> _last_sync{0};
+    // Serializes flushes. Threads waiting here get their writes covered by the running flush's successor at the latest.
+    std::mutex _sync_mutex;
 };
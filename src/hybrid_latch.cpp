@@ -0,0 +1,60 @@
+#include "hybrid_latch.hpp"
+
+#include <thread>
+
+uint64_t HybridLatch::optimistic_version() const {
+  while (true) {
+    const auto version = _version.load(std::memory_order_acquire);
+    if ((version & 1) == 0) {
+      return version;
+    }
+    std::this_thread::yield();
+  }
+}
+
+bool HybridLatch::validate(uint64_t version) const {
+  // Order all reads of the protected data before re-reading the version.
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return _version.load(std::memory_order_relaxed) == version;
+}
+
+bool HybridLatch::is_locked_exclusively() const {
+  return (_version.load(std::memory_order_acquire) & 1) == 1;
+}
+
+void HybridLatch::lock_shared() {
+  _mutex.lock_shared();
+}
+
+bool HybridLatch::try_lock_shared() {
+  return _mutex.try_lock_shared();
+}
+
+void HybridLatch::unlock_shared() {
+  _mutex.unlock_shared();
+}
+
+void HybridLatch::lock() {
+  _mutex.lock();
+  _begin_exclusive();
+}
+
+bool HybridLatch::try_lock() {
+  if (!_mutex.try_lock()) {
+    return false;
+  }
+  _begin_exclusive();
+  return true;
+}
+
+void HybridLatch::unlock() {
+  _version.fetch_add(1, std::memory_order_release);
+  _mutex.unlock();
+}
+
+void HybridLatch::_begin_exclusive() {
+  // The odd version has to be visible before any write to the protected data (see Boehm, "Can Seqlocks Get Along
+  // With Programming Language Memory Models?").
+  _version.fetch_add(1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+}
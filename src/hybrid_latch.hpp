@@ -0,0 +1,45 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <shared_mutex>
+
+// Versioned hybrid latch as described in the LeanStore line of work. The latch can be acquired in three modes:
+// (1) optimistic: a reader remembers the current version, reads the protected data without writing to the latch and
+// validates afterwards that the version did not change, (2) shared, and (3) exclusive. Every exclusive acquisition and
+// release increments the version, so an odd version indicates that the latch is currently held exclusively and any
+// optimistic read that overlaps with an exclusive section fails its validation.
+class HybridLatch {
+ public:
+  HybridLatch() = default;
+
+  // Returns the current version for an optimistic read. Spins while the latch is held exclusively, i.e., the returned
+  // version is always even.
+  uint64_t optimistic_version() const;
+
+  // Returns true if no exclusive section started or ended since `version` was obtained via `optimistic_version`.
+  bool validate(uint64_t version) const;
+
+  // Returns true if the latch is currently held exclusively.
+  bool is_locked_exclusively() const;
+
+  void lock_shared();
+  bool try_lock_shared();
+  void unlock_shared();
+
+  void lock();
+  bool try_lock();
+  void unlock();
+
+  // Delete move and copy
+  HybridLatch(const HybridLatch&) = delete;
+  HybridLatch(HybridLatch&&) = delete;
+  HybridLatch& operator=(const HybridLatch&) = delete;
+  HybridLatch& operator=(HybridLatch&&) = delete;
+
+ private:
+  void _begin_exclusive();
+
+  std::atomic<uint64_t> _version{0};
+  std::shared_mutex _mutex;
+};
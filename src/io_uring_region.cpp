@@ -0,0 +1,231 @@
+#include "io_uring_region.hpp"
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+
+namespace {
+
+// A single registered buffer must not be larger than 1 GiB.
+constexpr uint64_t MAX_REGISTERED_BUFFER_SIZE = GiB;
+
+int io_uring_setup(uint32_t entries, io_uring_params *params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int io_uring_enter(int ring_fd, uint32_t to_submit, uint32_t min_complete, uint32_t flags) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+int io_uring_register(int ring_fd, uint32_t opcode, const void *arg, uint32_t nr_args) {
+    return static_cast<int>(syscall(__NR_io_uring_register, ring_fd, opcode, arg, nr_args));
+}
+
+uint32_t load_acquire(uint32_t *value) {
+    return std::atomic_ref<uint32_t>(*value).load(std::memory_order_acquire);
+}
+
+void store_release(uint32_t *value, uint32_t new_value) {
+    std::atomic_ref<uint32_t>(*value).store(new_value, std::memory_order_release);
+}
+
+template <typename T>
+T *at_offset(void *base, uint32_t offset) {
+    return reinterpret_cast<T *>(reinterpret_cast<std::byte *>(base) + offset);
+}
+
+}  // namespace
+
+IoUringSSDRegion::IoUringSSDRegion(const std::filesystem::path &file_path, uint64_t page_count, uint32_t queue_depth,
+                                   OpenMode mode)
+        : SSDRegion(file_path, page_count, mode) {
+    _setup(queue_depth);
+}
+
+IoUringSSDRegion::~IoUringSSDRegion() {
+    if (_ring_fd < 0) {
+        return;
+    }
+    munmap(_sqes, _queue_depth * sizeof(io_uring_sqe));
+    if (_cq_ring != _sq_ring) {
+        munmap(_cq_ring, _cq_ring_size);
+    }
+    munmap(_sq_ring, _sq_ring_size);
+    close(_ring_fd);
+}
+
+void IoUringSSDRegion::_setup(uint32_t queue_depth) {
+    io_uring_params params{};
+    _ring_fd = io_uring_setup(queue_depth, &params);
+    if (_ring_fd < 0) {
+        return;
+    }
+    _queue_depth = params.sq_entries;
+
+    _sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    _cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap) {
+        _sq_ring_size = _cq_ring_size = std::max(_sq_ring_size, _cq_ring_size);
+    }
+
+    _sq_ring = mmap(nullptr, _sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ring_fd,
+                    IORING_OFF_SQ_RING);
+    _cq_ring = single_mmap ? _sq_ring : mmap(nullptr, _cq_ring_size, PROT_READ | PROT_WRITE,
+                                             MAP_SHARED | MAP_POPULATE, _ring_fd, IORING_OFF_CQ_RING);
+    _sqes = reinterpret_cast<io_uring_sqe *>(mmap(nullptr, _queue_depth * sizeof(io_uring_sqe),
+                                                  PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ring_fd,
+                                                  IORING_OFF_SQES));
+    if (_sq_ring == MAP_FAILED || _cq_ring == MAP_FAILED || _sqes == MAP_FAILED) {
+        close(_ring_fd);
+        _ring_fd = -1;
+        return;
+    }
+
+    _sq_tail = at_offset<uint32_t>(_sq_ring, params.sq_off.tail);
+    _sq_mask = at_offset<uint32_t>(_sq_ring, params.sq_off.ring_mask);
+    _sq_array = at_offset<uint32_t>(_sq_ring, params.sq_off.array);
+    _cq_head = at_offset<uint32_t>(_cq_ring, params.cq_off.head);
+    _cq_tail = at_offset<uint32_t>(_cq_ring, params.cq_off.tail);
+    _cq_mask = at_offset<uint32_t>(_cq_ring, params.cq_off.ring_mask);
+    _cqes = at_offset<io_uring_cqe>(_cq_ring, params.cq_off.cqes);
+}
+
+bool IoUringSSDRegion::register_buffers(std::byte *begin, std::byte *end) {
+    if (_ring_fd < 0) {
+        return false;
+    }
+
+    std::lock_guard lock(_ring_mutex);
+    auto iovecs = std::vector<iovec>{};
+    auto buffers = std::vector<std::span<std::byte>>{};
+    for (auto *chunk = begin; chunk < end; chunk += MAX_REGISTERED_BUFFER_SIZE) {
+        const auto size = std::min<uint64_t>(MAX_REGISTERED_BUFFER_SIZE, end - chunk);
+        iovecs.push_back({chunk, size});
+        buffers.emplace_back(chunk, size);
+    }
+
+    if (!_registered_buffers.empty()) {
+        io_uring_register(_ring_fd, IORING_UNREGISTER_BUFFERS, nullptr, 0);
+        _registered_buffers.clear();
+    }
+    if (io_uring_register(_ring_fd, IORING_REGISTER_BUFFERS, iovecs.data(), iovecs.size()) < 0) {
+        return false;
+    }
+    _registered_buffers = std::move(buffers);
+    return true;
+}
+
+void IoUringSSDRegion::read_pages(std::span<const PageIO> requests) {
+    if (_ring_fd < 0) {
+        SSDRegion::read_pages(requests);
+        return;
+    }
+    const auto to_read = _requests_to_read(requests);
+    _submit_and_wait(to_read, false);
+}
+
+void IoUringSSDRegion::write_pages(std::span<const PageIO> requests) {
+    if (_ring_fd < 0) {
+        SSDRegion::write_pages(requests);
+        return;
+    }
+    _submit_and_wait(requests, true);
+    for (const auto &request: requests) {
+        _mark_written(request.page_id);
+    }
+    _writes_completed(requests.size());
+}
+
+bool IoUringSSDRegion::uses_io_uring() const {
+    return _ring_fd >= 0;
+}
+
+bool IoUringSSDRegion::uses_registered_buffers() const {
+    return !_registered_buffers.empty();
+}
+
+void IoUringSSDRegion::_submit_and_wait(std::span<const PageIO> requests, bool write) {
+    std::lock_guard lock(_ring_mutex);
+
+    uint64_t next_request = 0;
+    uint64_t in_flight = 0;
+    while (next_request < requests.size() || in_flight > 0) {
+        // Refill the submission queue.
+        uint32_t to_submit = 0;
+        while (next_request < requests.size() && in_flight < _queue_depth) {
+            _prepare(requests[next_request], next_request, write);
+            ++next_request;
+            ++in_flight;
+            ++to_submit;
+        }
+
+        // Submit and wait for at least one completion.
+        while (io_uring_enter(_ring_fd, to_submit, 1, IORING_ENTER_GETEVENTS) < 0 && errno == EINTR) {
+            to_submit = 0;
+        }
+
+        // Reap all available completions.
+        auto head = *_cq_head;
+        while (head != load_acquire(_cq_tail)) {
+            const auto &cqe = _cqes[head & *_cq_mask];
+            if (cqe.res != static_cast<int32_t>(_page_size(requests[cqe.user_data].page_id))) {
+                _complete_blocking(requests[cqe.user_data], cqe.res, write);
+            }
+            ++head;
+            --in_flight;
+        }
+        store_release(_cq_head, head);
+    }
+}
+
+void IoUringSSDRegion::_prepare(const PageIO &request, uint64_t user_data, bool write) {
+    const auto tail = *_sq_tail;
+    const auto index = tail & *_sq_mask;
+    auto &sqe = _sqes[index];
+    std::memset(&sqe, 0, sizeof(sqe));
+
+    const auto buffer_index = _registered_buffer_index(request.buffer, _page_size(request.page_id));
+    if (buffer_index >= 0) {
+        sqe.opcode = write ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED;
+        sqe.buf_index = static_cast<uint16_t>(buffer_index);
+    } else {
+        sqe.opcode = write ? IORING_OP_WRITE : IORING_OP_READ;
+    }
+    sqe.fd = _file;
+    sqe.addr = reinterpret_cast<uint64_t>(request.buffer);
+    sqe.len = _page_size(request.page_id);
+    sqe.off = _page_offset(request.page_id);
+    sqe.user_data = user_data;
+
+    _sq_array[index] = index;
+    store_release(_sq_tail, tail + 1);
+}
+
+int32_t IoUringSSDRegion::_registered_buffer_index(const std::byte *buffer, uint64_t size) const {
+    for (uint64_t index = 0; index < _registered_buffers.size(); ++index) {
+        const auto &registered = _registered_buffers[index];
+        if (registered.data() <= buffer && buffer + size <= registered.data() + registered.size()) {
+            return static_cast<int32_t>(index);
+        }
+    }
+    return -1;
+}
+
+void IoUringSSDRegion::_complete_blocking(const PageIO &request, int32_t result, bool write) {
+    // Transfer the remaining bytes of a short transfer, or the whole page if the request failed (e.g., -EAGAIN).
+    const uint64_t done = result > 0 ? result : 0;
+    const uint64_t offset = _page_offset(request.page_id) + done;
+    const uint64_t remaining = _page_size(request.page_id) - done;
+    if (write) {
+        pwrite(_file, request.buffer + done, remaining, offset);
+    } else {
+        pread(_file, request.buffer + done, remaining, offset);
+    }
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <linux/io_uring.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <span>
+#include <vector>
+
+#include "data_regions.hpp"
+
+// SSD region that submits batched page reads and writes through io_uring, so that many requests are in flight at the
+// same time. Single-page reads and writes keep using the blocking calls of `SSDRegion`. We talk to the kernel via the
+// raw system calls and do not depend on liburing. If io_uring is not available (e.g., disabled by the kernel or a
+// seccomp filter), the region falls back to the blocking implementation of `SSDRegion`.
+class IoUringSSDRegion : public SSDRegion {
+public:
+    // Opens the file like `SSDRegion` and sets up a ring that holds up to `queue_depth` requests in flight.
+    IoUringSSDRegion(const std::filesystem::path &file_path, uint64_t page_count, uint32_t queue_depth = 64,
+                     OpenMode mode = OpenMode::CREATE);
+
+    ~IoUringSSDRegion() override;
+
+    // Registers the memory range [begin, end) as fixed buffers. Requests whose buffers are located within this range
+    // (e.g., the frames of a VolatileRegion) then use READ_FIXED/WRITE_FIXED, which saves pinning and unpinning the
+    // pages for every request. Returns false if the buffers could not be registered, e.g., because of RLIMIT_MEMLOCK.
+    bool register_buffers(std::byte *begin, std::byte *end);
+
+    void read_pages(std::span<const PageIO> requests) override;
+
+    void write_pages(std::span<const PageIO> requests) override;
+
+    // Returns whether requests are actually submitted through io_uring.
+    bool uses_io_uring() const;
+
+    // Returns whether fixed buffers are registered.
+    bool uses_registered_buffers() const;
+
+private:
+    // Submits all requests with the given opcode (read or write) and waits for their completion. At most
+    // `_queue_depth` requests are in flight; completed slots are refilled immediately.
+    void _submit_and_wait(std::span<const PageIO> requests, bool write);
+
+    // Prepares the next submission queue entry. Expects that a free entry exists.
+    void _prepare(const PageIO &request, uint64_t user_data, bool write);
+
+    // Returns the index of the registered buffer containing [buffer, buffer + size) or -1.
+    int32_t _registered_buffer_index(const std::byte *buffer, uint64_t size) const;
+
+    // Finishes a short or failed transfer with a blocking call.
+    void _complete_blocking(const PageIO &request, int32_t result, bool write);
+
+    void _setup(uint32_t queue_depth);
+
+    int32_t _ring_fd = -1;
+    uint32_t _queue_depth = 0;
+
+    // Memory mapped rings, see `man io_uring_setup`.
+    void *_sq_ring = nullptr;
+    uint64_t _sq_ring_size = 0;
+    void *_cq_ring = nullptr;
+    uint64_t _cq_ring_size = 0;
+    io_uring_sqe *_sqes = nullptr;
+
+    uint32_t *_sq_tail = nullptr;
+    uint32_t *_sq_mask = nullptr;
+    uint32_t *_sq_array = nullptr;
+    uint32_t *_cq_head = nullptr;
+    uint32_t *_cq_tail = nullptr;
+    uint32_t *_cq_mask = nullptr;
+    io_uring_cqe *_cqes = nullptr;
+
+    // Registered buffers. A single registered buffer is limited to 1 GiB, thus larger ranges are split.
+    std::vector<std::span<std::byte>> _registered_buffers{};
+
+    // The ring has a single submission and completion queue, thus only one batch is processed at a time.
+    std::mutex _ring_mutex;
+};
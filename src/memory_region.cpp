@@ -0,0 +1,41 @@
+#include "memory_region.hpp"
+
+#include <sys/mman.h>
+
+#include <cstring>
+
+MemoryRegion::MemoryRegion(const std::filesystem::path &file_path, uint64_t page_count)
+        : SSDRegion(file_path, page_count), _data_size(page_count * PAGE_SIZE) {
+    _data = reinterpret_cast<std::byte *>(mmap(nullptr, _data_size, PROT_READ | PROT_WRITE,
+                                               MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0));
+}
+
+MemoryRegion::~MemoryRegion() {
+    munmap(_data, _data_size);
+}
+
+void MemoryRegion::read_page(std::byte *destination, PageID page_id) {
+    // Pages that were never written read as zeros like in `SSDRegion`, their memory might not be mapped yet.
+    if (!_is_written(page_id)) {
+        std::memset(destination, 0, _page_size(page_id));
+        return;
+    }
+    std::memcpy(destination, _data + _page_offset(page_id), _page_size(page_id));
+}
+
+void MemoryRegion::write_page(const std::byte *source, PageID page_id) {
+    std::memcpy(_data + _page_offset(page_id), source, _page_size(page_id));
+    _mark_written(page_id);
+}
+
+void MemoryRegion::read_pages(std::span<const PageIO> requests) {
+    for (const auto &request: requests) {
+        read_page(request.buffer, request.page_id);
+    }
+}
+
+void MemoryRegion::write_pages(std::span<const PageIO> requests) {
+    for (const auto &request: requests) {
+        write_page(request.buffer, request.page_id);
+    }
+}
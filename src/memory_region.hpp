@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <span>
+
+#include "data_regions.hpp"
+
+// SSD region that keeps the pages in memory instead of the file, e.g., to replay access traces at full speed (see
+// test/trace_replay.cpp). The file at `file_path` and its free space map are still created, but the file is only grown
+// sparsely and never written. The memory is mapped lazily, thus only written pages take physical memory. Writes are
+// never synced.
+class MemoryRegion : public SSDRegion {
+public:
+    MemoryRegion(const std::filesystem::path &file_path, uint64_t page_count);
+
+    ~MemoryRegion() override;
+
+    void read_page(std::byte *destination, PageID page_id) override;
+
+    void write_page(const std::byte *source, PageID page_id) override;
+
+    void read_pages(std::span<const PageIO> requests) override;
+
+    void write_pages(std::span<const PageIO> requests) override;
+
+private:
+    std::byte *_data = nullptr;
+    uint64_t _data_size = 0;
+};
@@ -0,0 +1,198 @@
+#include "statistics.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <sstream>
+#include <utility>
+
+namespace {
+
+std::atomic<uint64_t> next_collector_id{1};
+
+// Names of the counters (and the cooling target) and histograms in the order of `Statistics`' members, shared by the text and JSON formats.
+std::array<std::pair<const char *, uint64_t>, 14> counters(const Statistics &statistics) {
+    return {{{"hits", statistics.hits},
+             {"cooling_rescues", statistics.cooling_rescues},
+             {"misses", statistics.misses},
+             {"pages_cooled", statistics.pages_cooled},
+             {"evictions", statistics.evictions},
+             {"eviction_flushes", statistics.eviction_flushes},
+             {"pages_read", statistics.pages_read},
+             {"bytes_read", statistics.bytes_read},
+             {"pages_written", statistics.pages_written},
+             {"bytes_written", statistics.bytes_written},
+             {"cooling_target_increases", statistics.cooling_target_increases},
+             {"cooling_target_decreases", statistics.cooling_target_decreases},
+             {"cooling_target", statistics.cooling_target},
+             {"sampling_iterations", statistics.sampling_iterations}}};
+}
+
+std::array<std::pair<const char *, const LatencyHistogram *>, 3> histograms(const Statistics &statistics) {
+    return {{{"read_latency_ns", &statistics.read_latency},
+             {"write_latency_ns", &statistics.write_latency},
+             {"miss_latency_ns", &statistics.miss_latency}}};
+}
+
+}  // namespace
+
+thread_local StatisticsCollector::LocalStatistics StatisticsCollector::_local_statistics{};
+
+void LatencyHistogram::record(uint64_t value) {
+    ++counts[bucket(value)];
+    ++total;
+    sum += value;
+    maximum = std::max(maximum, value);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &other) {
+    for (uint64_t index = 0; index < BUCKET_COUNT; ++index) {
+        counts[index] += other.counts[index];
+    }
+    total += other.total;
+    sum += other.sum;
+    maximum = std::max(maximum, other.maximum);
+}
+
+uint64_t LatencyHistogram::count() const {
+    return total;
+}
+
+double LatencyHistogram::mean() const {
+    return total ? static_cast<double>(sum) / total : 0;
+}
+
+uint64_t LatencyHistogram::max() const {
+    return maximum;
+}
+
+uint64_t LatencyHistogram::percentile(double percentile) const {
+    const auto rank = std::max<uint64_t>(static_cast<uint64_t>(std::ceil(percentile * total)), 1);
+    uint64_t seen = 0;
+    for (uint64_t index = 0; index < BUCKET_COUNT; ++index) {
+        seen += counts[index];
+        if (seen >= rank) {
+            // The bucket's upper bound might exceed the largest recorded value.
+            return std::min(upper_bound(index), maximum);
+        }
+    }
+    return 0;
+}
+
+uint64_t LatencyHistogram::bucket(uint64_t value) {
+    if (value < SUB_BUCKETS) {
+        return value;
+    }
+    const uint64_t exponent = std::bit_width(value) - 1;
+    const uint64_t sub_bucket = (value >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1);
+    return (exponent - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + sub_bucket;
+}
+
+uint64_t LatencyHistogram::upper_bound(uint64_t bucket) {
+    if (bucket < SUB_BUCKETS) {
+        return bucket;
+    }
+    const uint64_t exponent = bucket / SUB_BUCKETS + SUB_BUCKET_BITS - 1;
+    const uint64_t shift = exponent - SUB_BUCKET_BITS;
+    // The sum might overflow for the last bucket, which then yields the largest value.
+    return ((SUB_BUCKETS + bucket % SUB_BUCKETS + 1) << shift) - 1;
+}
+
+double Statistics::hit_rate() const {
+    const auto accesses = hits + cooling_rescues + misses;
+    return accesses ? static_cast<double>(hits + cooling_rescues) / accesses : 0;
+}
+
+std::string Statistics::to_text() const {
+    std::ostringstream text;
+    for (const auto &[name, value]: counters(*this)) {
+        text << name << ": " << value << '\n';
+    }
+    text << "hit_rate: " << hit_rate() << '\n';
+    for (const auto &[name, histogram]: histograms(*this)) {
+        text << name << ": count " << histogram->count() << ", mean " << histogram->mean() << ", p50 "
+             << histogram->percentile(0.5) << ", p99 " << histogram->percentile(0.99) << ", p999 "
+             << histogram->percentile(0.999) << ", max " << histogram->max() << '\n';
+    }
+    return text.str();
+}
+
+std::string Statistics::to_json() const {
+    std::ostringstream json;
+    json << '{';
+    for (const auto &[name, value]: counters(*this)) {
+        json << '"' << name << "\":" << value << ',';
+    }
+    json << "\"hit_rate\":" << hit_rate();
+    for (const auto &[name, histogram]: histograms(*this)) {
+        json << ",\"" << name << "\":{\"count\":" << histogram->count() << ",\"mean\":" << histogram->mean()
+             << ",\"p50\":" << histogram->percentile(0.5) << ",\"p99\":" << histogram->percentile(0.99)
+             << ",\"p999\":" << histogram->percentile(0.999) << ",\"max\":" << histogram->max() << '}';
+    }
+    json << '}';
+    return json.str();
+}
+
+StatisticsCollector::StatisticsCollector() : _id(next_collector_id.fetch_add(1, std::memory_order_relaxed)) {}
+
+Statistics StatisticsCollector::collect() const {
+    auto counter_sums = std::array<uint64_t, COUNTER_COUNT>{};
+    auto latencies = std::array<LatencyHistogram, LATENCY_COUNT>{};
+    {
+        std::lock_guard lock(_mutex);
+        for (const auto &[thread, statistics]: _threads) {
+            for (uint32_t counter = 0; counter < COUNTER_COUNT; ++counter) {
+                counter_sums[counter] += statistics->counters[counter].load(std::memory_order_relaxed);
+            }
+            for (uint32_t latency = 0; latency < LATENCY_COUNT; ++latency) {
+                auto &histogram = latencies[latency];
+                for (uint64_t index = 0; index < LatencyHistogram::BUCKET_COUNT; ++index) {
+                    histogram.counts[index] += statistics->buckets[latency][index].load(std::memory_order_relaxed);
+                }
+                histogram.total += statistics->totals[latency].load(std::memory_order_relaxed);
+                histogram.sum += statistics->sums[latency].load(std::memory_order_relaxed);
+                histogram.maximum = std::max(histogram.maximum,
+                                             statistics->maximums[latency].load(std::memory_order_relaxed));
+            }
+        }
+    }
+
+    auto counter = [&counter_sums](Counter counter) { return counter_sums[static_cast<uint32_t>(counter)]; };
+    auto statistics = Statistics{};
+    statistics.hits = counter(Counter::HITS);
+    statistics.cooling_rescues = counter(Counter::COOLING_RESCUES);
+    statistics.misses = counter(Counter::MISSES);
+    statistics.pages_cooled = counter(Counter::PAGES_COOLED);
+    statistics.evictions = counter(Counter::EVICTIONS);
+    statistics.eviction_flushes = counter(Counter::EVICTION_FLUSHES);
+    statistics.pages_read = counter(Counter::PAGES_READ);
+    statistics.bytes_read = counter(Counter::BYTES_READ);
+    statistics.pages_written = counter(Counter::PAGES_WRITTEN);
+    statistics.bytes_written = counter(Counter::BYTES_WRITTEN);
+    statistics.cooling_target_increases = counter(Counter::COOLING_TARGET_INCREASES);
+    statistics.cooling_target_decreases = counter(Counter::COOLING_TARGET_DECREASES);
+    statistics.sampling_iterations = counter(Counter::SAMPLING_ITERATIONS);
+    statistics.read_latency = latencies[static_cast<uint32_t>(Latency::READ)];
+    statistics.write_latency = latencies[static_cast<uint32_t>(Latency::WRITE)];
+    statistics.miss_latency = latencies[static_cast<uint32_t>(Latency::MISS)];
+    return statistics;
+}
+
+void StatisticsCollector::ThreadStatistics::record(uint32_t latency, uint64_t value) {
+    _increment(buckets[latency][LatencyHistogram::bucket(value)], 1);
+    _increment(totals[latency], 1);
+    _increment(sums[latency], value);
+    if (value > maximums[latency].load(std::memory_order_relaxed)) {
+        maximums[latency].store(value, std::memory_order_relaxed);
+    }
+}
+
+void StatisticsCollector::_register_thread() {
+    std::lock_guard lock(_mutex);
+    // A thread ID might be reused by a later thread, which then continues the counters of the finished thread.
+    auto &statistics = _threads[std::this_thread::get_id()];
+    if (!statistics) {
+        statistics = std::make_unique<ThreadStatistics>();
+    }
+    _local_statistics = {_id, statistics.get()};
+}
@@ -0,0 +1,206 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include "config.hpp"
+
+// Whether the buffer manager collects statistics (see `BM_COLLECT_STATISTICS`).
+constexpr bool COLLECT_STATISTICS = BM_COLLECT_STATISTICS;
+
+// Log-linear histogram of latencies in nanoseconds with 16 buckets per power of two, i.e., a recorded value is off by at
+// most 1/16 of it. Not thread-safe.
+class LatencyHistogram {
+ public:
+  static constexpr uint64_t SUB_BUCKET_BITS = 4;
+  static constexpr uint64_t SUB_BUCKETS = uint64_t{1} << SUB_BUCKET_BITS;
+  static constexpr uint64_t BUCKET_COUNT = 64 * SUB_BUCKETS;
+
+  void record(uint64_t value);
+
+  // Adds the values recorded by the other histogram.
+  void merge(const LatencyHistogram& other);
+
+  // Returns the number of recorded values.
+  uint64_t count() const;
+
+  // Returns the mean of the recorded values, or 0 if no value was recorded.
+  double mean() const;
+
+  // Returns the largest recorded value.
+  uint64_t max() const;
+
+  // Returns the upper bound of the bucket that contains the percentile (in [0, 1]), or 0 if no value was recorded.
+  uint64_t percentile(double percentile) const;
+
+  // Returns the bucket of the value.
+  static uint64_t bucket(uint64_t value);
+
+  // Returns the largest value of the bucket.
+  static uint64_t upper_bound(uint64_t bucket);
+
+  // Number of recorded values per bucket.
+  std::array<uint64_t, BUCKET_COUNT> counts{};
+  uint64_t total = 0;
+  uint64_t sum = 0;
+  uint64_t maximum = 0;
+};
+
+// Snapshot of the buffer manager's statistics (see `BufferManager::statistics`). All counters count from the buffer
+// manager's creation.
+struct Statistics {
+  // `get_frame` and `get_frames` accesses that found the page in memory without swizzling it, i.e., hot pages and
+  // cooling pages accessed with `AccessMode::SCAN`.
+  uint64_t hits = 0;
+  // Accesses that found the page in the cooling stage and swizzled it again (see LeanStore, Section III. C.).
+  uint64_t cooling_rescues = 0;
+  // Accesses that loaded the page from the SSD region.
+  uint64_t misses = 0;
+  // Pages added to the cooling stage.
+  uint64_t pages_cooled = 0;
+  // Evicted pages, and the number of them that were dirty and thus had to be written back during the eviction.
+  uint64_t evictions = 0;
+  uint64_t eviction_flushes = 0;
+  // Pages and bytes read from and written to the SSD region, including prefetches and the background writer.
+  uint64_t pages_read = 0;
+  uint64_t bytes_read = 0;
+  uint64_t pages_written = 0;
+  uint64_t bytes_written = 0;
+  // Changes of the cooling target by the adaptive cooling stage (see `CoolingStageConfig::adaptive`), and the target at
+  // the time of the snapshot (see `BufferManager::cooling_target`).
+  uint64_t cooling_target_increases = 0;
+  uint64_t cooling_target_decreases = 0;
+  uint64_t cooling_target = 0;
+  // Frames sampled to fill the cooling stage, i.e., by `_create_cooling_state_share` and when no frame of a size class
+  // is cooling.
+  uint64_t sampling_iterations = 0;
+
+  // Latencies in nanoseconds of the SSD region's read and write calls (one value per call, which might read or write a
+  // batch of pages) and of `get_frame` calls that missed.
+  LatencyHistogram read_latency{};
+  LatencyHistogram write_latency{};
+  LatencyHistogram miss_latency{};
+
+  // Returns the share of accesses that did not have to load the page, or 0 without accesses.
+  double hit_rate() const;
+
+  // Returns a human-readable representation with one line per value.
+  std::string to_text() const;
+
+  // Returns a JSON object. Histograms are summarized by their count, mean, percentiles (p50, p99, p999), and maximum.
+  std::string to_json() const;
+};
+
+// Counters of `Statistics`.
+enum class Counter : uint32_t {
+  HITS,
+  COOLING_RESCUES,
+  MISSES,
+  PAGES_COOLED,
+  EVICTIONS,
+  EVICTION_FLUSHES,
+  PAGES_READ,
+  BYTES_READ,
+  PAGES_WRITTEN,
+  BYTES_WRITTEN,
+  SAMPLING_ITERATIONS,
+  COOLING_TARGET_INCREASES,
+  COOLING_TARGET_DECREASES,
+  COUNT
+};
+
+// Latency histograms of `Statistics`.
+enum class Latency : uint32_t { READ, WRITE, MISS, COUNT };
+
+// Collects statistics with per-thread counters, so that recording a value neither takes a lock nor writes to a cache
+// line shared with other threads. Every thread only writes its own counters, thus a relaxed load and store suffice
+// instead of an atomic read-modify-write. `collect` sums the counters of all threads, including threads that finished.
+// With BM_COLLECT_STATISTICS disabled, recording does nothing.
+class StatisticsCollector {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  StatisticsCollector();
+
+  void add(Counter counter, uint64_t value = 1) {
+    if constexpr (COLLECT_STATISTICS) {
+      _increment(_local().counters[static_cast<uint32_t>(counter)], value);
+    }
+  }
+
+  // Returns the start time of a latency measurement (see `record`).
+  static Clock::time_point start() {
+    if constexpr (COLLECT_STATISTICS) {
+      return Clock::now();
+    }
+    return {};
+  }
+
+  // Records the time elapsed since `start` in the histogram.
+  void record(Latency latency, Clock::time_point start) {
+    if constexpr (COLLECT_STATISTICS) {
+      const auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+      _local().record(static_cast<uint32_t>(latency), nanoseconds);
+    }
+  }
+
+  // Returns the sum of all threads' statistics. The counters of different threads are read one after another, thus the
+  // result is not a consistent snapshot under concurrent updates.
+  Statistics collect() const;
+
+  // Delete move and copy
+  StatisticsCollector(const StatisticsCollector&) = delete;
+  StatisticsCollector(StatisticsCollector&&) = delete;
+  StatisticsCollector& operator=(const StatisticsCollector&) = delete;
+  StatisticsCollector& operator=(StatisticsCollector&&) = delete;
+
+ private:
+  static constexpr uint32_t COUNTER_COUNT = static_cast<uint32_t>(Counter::COUNT);
+  static constexpr uint32_t LATENCY_COUNT = static_cast<uint32_t>(Latency::COUNT);
+
+  // Statistics of one thread. Cache line aligned to avoid false sharing between threads.
+  struct alignas(64) ThreadStatistics {
+    std::array<std::atomic<uint64_t>, COUNTER_COUNT> counters{};
+    // Bucket counts, total, sum, and maximum per histogram (see `LatencyHistogram`).
+    std::array<std::array<std::atomic<uint64_t>, LatencyHistogram::BUCKET_COUNT>, LATENCY_COUNT> buckets{};
+    std::array<std::atomic<uint64_t>, LATENCY_COUNT> totals{};
+    std::array<std::atomic<uint64_t>, LATENCY_COUNT> sums{};
+    std::array<std::atomic<uint64_t>, LATENCY_COUNT> maximums{};
+
+    void record(uint32_t latency, uint64_t value);
+  };
+
+  // The calling thread's statistics of the collector it used last. Collectors are identified by a unique ID instead of
+  // their address, which might be reused by a later collector.
+  struct LocalStatistics {
+    uint64_t collector_id = 0;
+    ThreadStatistics* statistics = nullptr;
+  };
+
+  static void _increment(std::atomic<uint64_t>& counter, uint64_t value) {
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+  }
+
+  ThreadStatistics& _local() {
+    if (_local_statistics.collector_id != _id) [[unlikely]] {
+      _register_thread();
+    }
+    return *_local_statistics.statistics;
+  }
+
+  // Looks up or creates the calling thread's statistics and caches them in `_local_statistics`.
+  void _register_thread();
+
+  static thread_local LocalStatistics _local_statistics;
+
+  const uint64_t _id;
+  mutable std::mutex _mutex;
+  std::unordered_map<std::thread::id, std::unique_ptr<ThreadStatistics>> _threads;
+};
@@ -1,5 +1,7 @@
 #include "swip.hpp"
 
+#include <atomic>
+
 #include "buffer_frame.hpp"
 
 Swip::Swip() : pageId(INVALID_PAGE_ID << NUMBER_OF_BITS_FOR_TAGGING | evictedBits) {}
@@ -9,41 +11,52 @@ Swip::Swip(PageID page_id) : pageId(page_id << NUMBER_OF_BITS_FOR_TAGGING | evic
 Swip::Swip(BufferFrame *buffer_frame) : pBufferFrame(buffer_frame) {}
 
 bool Swip::is_swizzled() {
-    return (pageId & comparisonMask) == hotBits;
+    return (_load() & comparisonMask) == hotBits;
 };
 
 bool Swip::is_cooling() {
-    return (pageId & comparisonMask) == coolingBits;
+    return (_load() & comparisonMask) == coolingBits;
 }
 
 bool Swip::is_evicted() {
-    return (pageId & comparisonMask) == evictedBits;
+    return (_load() & comparisonMask) == evictedBits;
 }
 
 void Swip::swizzle() {
-    this->pageId = this->pageId & ~coolingBits;
+    _store(_load() & ~coolingBits);
 }
 
 void Swip::swizzle(BufferFrame *buffer_frame) {
-    this->pBufferFrame = buffer_frame;
+    _store(reinterpret_cast<uint64_t>(buffer_frame));
 }
 
 void Swip::unswizzle() {
-    this->pageId = this->pageId | coolingBits;
+    _store(_load() | coolingBits);
 }
 
 void Swip::evict(PageID page_id) {
-    this->pageId = ((page_id << NUMBER_OF_BITS_FOR_TAGGING) | evictedBits);
+    _store((page_id << NUMBER_OF_BITS_FOR_TAGGING) | evictedBits);
 }
 
 PageID Swip::page_id() {
-    return (this->pageId >> NUMBER_OF_BITS_FOR_TAGGING);
+    return (_load() >> NUMBER_OF_BITS_FOR_TAGGING);
 }
 
 BufferFrame *Swip::buffer_frame() {
-    return this->pBufferFrame;
+    return reinterpret_cast<BufferFrame *>(_load());
 }
 
 BufferFrame *Swip::buffer_frame_ignore_tags() {
-    return reinterpret_cast<BufferFrame *>(this->pageId & ~comparisonMask);
+    return reinterpret_cast<BufferFrame *>(_load() & ~comparisonMask);
+}
+
+uint64_t Swip::_load() {
+    // Swips are read without holding the buffer manager's lock (e.g., resolving a swizzled swip), while state
+    // transitions are performed by other threads. Acquire pairs with the release in `_store`, so a reader that sees a
+    // swizzled swip also sees the initialized frame.
+    return std::atomic_ref<uint64_t>(pageId).load(std::memory_order_acquire);
+}
+
+void Swip::_store(uint64_t value) {
+    std::atomic_ref<uint64_t>(pageId).store(value, std::memory_order_release);
 }
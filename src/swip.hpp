@@ -7,7 +7,8 @@
 // it stores a pointer to a buffer frame but one or multiple bits are flipped to indicate that the referenced frame is
 // unswizzled/cooling. Alternatively, a swip can be (3) unswizzled/evicted, i.e., it does not store a valid frame
 // address but a page id instead. Similar to the unswizzeld/cooling state, individual bits might be used to indicate
-// this swip state. You can use the two least significant bits for indicating the states / pointer tagging.
+// this swip state. You can use the two least significant bits for indicating the states / pointer tagging. The tag
+// layout is configurable at compile time (see BM_SWIP_TAG_BITS).
 
 class Swip {
 public:
@@ -57,6 +58,11 @@ public:
     BufferFrame *buffer_frame_ignore_tags();
 
 private:
+    // Atomic accessors for the tagged word. All state transitions of a swip go through these.
+    uint64_t _load();
+
+    void _store(uint64_t value);
+
     // Note, that a swip stores either a buffer frame pointer or a page id. The size of a swip thus should be 8 Byte.
     // You might want do define constants here for bit modifications and comparisons.
     union {
@@ -64,15 +70,15 @@ private:
         BufferFrame *pBufferFrame;
     };
 
-    // NOTE: we use this layout because we can easily see by the last bit if (0) hot/cool or (1) evicted
+    // NOTE: we use this layout (by default) because we can easily see by the last bit if (0) hot/cool or (1) evicted
     // x00
-    static const uint64_t hotBits = uint64_t(0);
+    static constexpr uint64_t hotBits = uint64_t(0);
     // x10
-    static const uint64_t coolingBits = uint64_t(2);
+    static constexpr uint64_t coolingBits = uint64_t(BM_SWIP_COOLING_TAG);
     // x01
-    static const uint64_t evictedBits = uint64_t(1);
+    static constexpr uint64_t evictedBits = uint64_t(BM_SWIP_EVICTED_TAG);
 
-    static const uint8_t NUMBER_OF_BITS_FOR_TAGGING = 2;
+    static constexpr uint8_t NUMBER_OF_BITS_FOR_TAGGING = SWIP_TAG_BITS;
     // x11
-    static const uint64_t comparisonMask = uint64_t(3);
+    static constexpr uint64_t comparisonMask = (uint64_t(1) << NUMBER_OF_BITS_FOR_TAGGING) - 1;
 };
@@ -0,0 +1,59 @@
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <vector>
+
+#include "data_regions.hpp"
+
+// Micro benchmarks of the volatile region's frame allocator. All threads of a benchmark share one region, so the
+// results show how allocate/free throughput scales from one to many threads.
+
+namespace {
+
+constexpr uint64_t FRAME_COUNT = 64 * 1024;
+
+std::unique_ptr<VolatileRegion> region;
+
+void create_region(const benchmark::State &state) {
+  region = std::make_unique<VolatileRegion>(FRAME_COUNT, state.range(0));
+}
+
+void destroy_region(const benchmark::State &) {
+  region.reset();
+}
+
+}  // namespace
+
+// Allocates a single frame and frees it again. This is the common case that should be served by the magazines.
+static void BM_AllocateFree(benchmark::State &state) {
+  for (auto _ : state) {
+    auto *frame = region->allocate_frame();
+    benchmark::DoNotOptimize(frame);
+    region->free_frame(frame);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// Allocates more frames than a magazine holds before freeing them, so that frames move between the magazines and the
+// partitions' free frame stacks.
+static void BM_AllocateFreeBatch(benchmark::State &state) {
+  constexpr uint64_t batch_size = 64;
+  auto frames = std::vector<BufferFrame *>(batch_size);
+  for (auto _ : state) {
+    for (auto &frame : frames) {
+      frame = region->allocate_frame();
+    }
+    for (auto *frame : frames) {
+      region->free_frame(frame);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * batch_size);
+}
+
+// Argument: number of partitions.
+BENCHMARK(BM_AllocateFree)->Arg(1)->Arg(8)->ThreadRange(1, 64)->UseRealTime()->Setup(create_region)
+    ->Teardown(destroy_region);
+BENCHMARK(BM_AllocateFreeBatch)->Arg(1)->Arg(8)->ThreadRange(1, 64)->UseRealTime()->Setup(create_region)
+    ->Teardown(destroy_region);
+
+BENCHMARK_MAIN();
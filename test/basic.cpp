@@ -1,15 +1,23 @@
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <cmath>
 #include <cstring>
 #include <iostream>
+#include <numeric>
+#include <random>
 #include <typeinfo>
 #include <unordered_map>
 #include <unordered_set>
 #include <bitset>
+#include <thread>
+#include <tuple>
 
+#include "btree.hpp"
 #include "buffer_frame.hpp"
 #include "buffer_manager.hpp"
+#include "io_uring_region.hpp"
+#include "memory_region.hpp"
 #include "gtest/gtest.h"
 #include "test_utils.hpp"
 
@@ -93,6 +101,59 @@ TEST_F(BufferFrameTest, Data) {
     EXPECT_EQ(frame->page.payload.data(), frame->page.data());
 }
 
+///////////////////////////////////////////////////////////
+//// Hybrid Latch
+///////////////////////////////////////////////////////////
+
+class HybridLatchTest : public BasicTest {
+};
+
+TEST_F(HybridLatchTest, OptimisticValidation) {
+    HybridLatch latch{};
+    const auto version = latch.optimistic_version();
+    EXPECT_TRUE(latch.validate(version));
+
+    // Shared readers do not invalidate optimistic readers.
+    latch.lock_shared();
+    EXPECT_TRUE(latch.try_lock_shared());
+    EXPECT_FALSE(latch.try_lock());
+    EXPECT_TRUE(latch.validate(version));
+    latch.unlock_shared();
+    latch.unlock_shared();
+
+    latch.lock();
+    EXPECT_TRUE(latch.is_locked_exclusively());
+    EXPECT_FALSE(latch.validate(version));
+    EXPECT_FALSE(latch.try_lock_shared());
+    latch.unlock();
+    EXPECT_FALSE(latch.is_locked_exclusively());
+    EXPECT_FALSE(latch.validate(version));
+    EXPECT_TRUE(latch.validate(latch.optimistic_version()));
+}
+
+TEST_F(HybridLatchTest, EvictionInvalidatesOptimisticReaders) {
+    std::unique_ptr<BufferManager> buffer_manager = create_default_bm();
+    auto swip = Swip{PageID{0}};
+    buffer_manager->register_callbacks({nullptr, [&swip](BufferFrame *, ManagedDataStructure *) -> Swip & {
+        return swip;
+    }});
+
+    auto frame = buffer_manager->allocate_page();
+    swip = Swip(frame);
+    const auto version = frame->latch.optimistic_version();
+
+    // A latched frame is not evicted.
+    frame->latch.lock_shared();
+    buffer_manager->_add_eviction_candidate(frame);
+    EXPECT_FALSE(buffer_manager->_evict_page());
+    EXPECT_TRUE(swip.is_cooling());
+    frame->latch.unlock_shared();
+
+    EXPECT_TRUE(buffer_manager->_evict_page());
+    EXPECT_TRUE(swip.is_evicted());
+    EXPECT_FALSE(frame->latch.validate(version));
+}
+
 ///////////////////////////////////////////////////////////
 //// Swip
 //////////////////////////////////////////////////////////
@@ -299,6 +360,128 @@ TEST_F(VolatileDataRegionTest, AllocateAndFreeFrames) {
     EXPECT_EQ(region.free_frame_count(), 29);
 }
 
+TEST_F(VolatileDataRegionTest, Partitions) {
+    VolatileRegion region{8, 4};
+    ASSERT_EQ(region.partition_count(), 4);
+    BufferFrame *frames = region.frames();
+    for (auto index = 0; index < 8; ++index) {
+        EXPECT_EQ(region.partition_of(frames + index), index / 2);
+    }
+
+    // Allocations steal from other partitions once the home partition is empty.
+    auto allocated = std::vector<BufferFrame *>{};
+    for (auto index = 0; index < 8; ++index) {
+        allocated.push_back(region.allocate_frame());
+        ASSERT_NE(allocated.back(), nullptr);
+    }
+    EXPECT_EQ(region.free_frame_count(), 0);
+    EXPECT_EQ(region.allocate_frame(), nullptr);
+    std::sort(allocated.begin(), allocated.end());
+    EXPECT_EQ(std::unique(allocated.begin(), allocated.end()), allocated.end());
+
+    // A freed frame returns to its own partition.
+    region.free_frame(frames + 5);
+    EXPECT_EQ(region.free_frame_count(), 1);
+    EXPECT_EQ(region.allocate_frame(), frames + 5);
+}
+
+TEST_F(VolatileDataRegionTest, SizeClasses) {
+    VolatileRegion region{{4, 2, 1, 1}};
+    EXPECT_EQ(region.frame_count(), 8);
+    EXPECT_EQ(region.frame_count(PageSizeClass::SIZE_16K), 2);
+    EXPECT_EQ(region.free_frame_count(PageSizeClass::SIZE_256K), 1);
+
+    auto *small = region.allocate_frame();
+    auto *medium = region.allocate_frame(PageSizeClass::SIZE_16K);
+    auto *large = region.allocate_frame(PageSizeClass::SIZE_256K);
+    ASSERT_NE(large, nullptr);
+    EXPECT_EQ(small->size_class, PageSizeClass::SIZE_4K);
+    EXPECT_EQ(medium->size_class, PageSizeClass::SIZE_16K);
+    EXPECT_EQ(large->page_size(), 256 * KiB);
+    EXPECT_EQ(region.frame_at(4), medium);
+    EXPECT_EQ(region.frame_at(PageSizeClass::SIZE_16K, 1),
+              reinterpret_cast<BufferFrame *>(reinterpret_cast<std::byte *>(medium) +
+                                              VolatileRegion::frame_size(PageSizeClass::SIZE_16K)));
+    EXPECT_TRUE(region.address_in_range(large->page.data() + large->page_size() - 1));
+    EXPECT_EQ(region.allocate_frame(PageSizeClass::SIZE_256K), nullptr);
+    EXPECT_EQ(region.free_frame_count(), 5);
+
+    // The whole page belongs to the frame and is zeroed when the frame is freed.
+    std::memset(large->page.data(), 0xAB, large->page_size());
+    region.free_frame(large);
+    EXPECT_EQ(region.allocate_frame(PageSizeClass::SIZE_256K), large);
+    EXPECT_EQ(large->page.data()[large->page_size() - 1], std::byte{0});
+}
+
+TEST_F(VolatileDataRegionTest, OccupancyBitmap) {
+    VolatileRegion region{{130, 2, 0, 0}};
+    BufferFrame *frames = region.frames();
+    EXPECT_EQ(region.next_hot_frame(frames), nullptr);
+
+    // Allocate the frames 0 to 99, then only keep 70 and 90 hot. The search continues in the next words.
+    auto allocated = std::vector<BufferFrame *>{};
+    for (auto index = 0; index < 100; ++index) {
+        allocated.push_back(region.allocate_frame());
+    }
+    for (auto *frame: allocated) {
+        if (frame == frames + 70) {
+            continue;
+        }
+        if (frame == frames + 90) {
+            region.set_cooling(frame, true);
+            region.set_cooling(frame, false);
+            continue;
+        }
+        if (frame < frames + 50) {
+            region.set_cooling(frame, true);
+        } else {
+            region.free_frame(frame);
+        }
+    }
+    EXPECT_EQ(region.next_hot_frame(frames), frames + 70);
+    EXPECT_EQ(region.next_hot_frame(frames + 71), frames + 90);
+    // Wraps around at the end of the size class.
+    EXPECT_EQ(region.next_hot_frame(frames + 91), frames + 70);
+
+    // Frames of other size classes are not considered.
+    region.free_frame(frames + 70);
+    region.set_cooling(frames + 90, true);
+    EXPECT_EQ(region.next_hot_frame(frames + 129), nullptr);
+    auto *medium = region.allocate_frame(PageSizeClass::SIZE_16K);
+    EXPECT_EQ(region.next_hot_frame(frames), nullptr);
+    EXPECT_EQ(region.next_hot_frame(region.frame_at(PageSizeClass::SIZE_16K, 1)), medium);
+
+    // Freeing a cooling frame clears its cooling bit.
+    region.free_frame(frames + 90);
+    EXPECT_EQ(region.allocate_frame(), frames + 90);
+    EXPECT_EQ(region.next_hot_frame(frames), frames + 90);
+}
+
+TEST_F(VolatileDataRegionTest, MemoryPolicies) {
+    auto policies = std::vector<MemoryPolicy>{
+            {MemoryPolicy::HugePages::NONE, 0, MemoryPolicy::NumaPlacement::DEFAULT, {}},
+            {MemoryPolicy::HugePages::EXPLICIT, 0, MemoryPolicy::NumaPlacement::DEFAULT, {}},
+            {MemoryPolicy::HugePages::TRANSPARENT, 4, MemoryPolicy::NumaPlacement::INTERLEAVE, {}},
+            {MemoryPolicy::HugePages::TRANSPARENT, 3, MemoryPolicy::NumaPlacement::PARTITIONED, {0}},
+    };
+    for (const auto &policy: policies) {
+        // Whether the policies are applied depends on the system, but the region must be usable either way.
+        VolatileRegion region{{100, 3, 0, 1}, 4, policy};
+        EXPECT_EQ(region.free_frame_count(), 104);
+        if (policy.huge_pages != MemoryPolicy::HugePages::EXPLICIT) {
+            EXPECT_FALSE(region.uses_explicit_huge_pages());
+        }
+        auto *large = region.allocate_frame(PageSizeClass::SIZE_256K);
+        ASSERT_NE(large, nullptr);
+        std::memset(large->page.data(), 0xAB, large->page_size());
+        EXPECT_TRUE(region.address_in_range(large->page.data() + large->page_size() - 1));
+        auto *small = region.allocate_frame();
+        ASSERT_NE(small, nullptr);
+        store_u64(small, 42);
+        EXPECT_EQ(get_u64(small), 42);
+    }
+}
+
 TEST_F(SSDDataRegionTest, WriteRead) {
     const auto page_count = 10;
     SSDRegion region{_ssd_path, page_count};
@@ -323,6 +506,263 @@ TEST_F(SSDDataRegionTest, WriteRead) {
     EXPECT_NE(memcmp(read_page_4.data(), read_page_7.data(), EFFECTIVE_PAGE_SIZE), 0);
 }
 
+TEST_F(SSDDataRegionTest, SyncPolicies) {
+    SSDRegion region{_ssd_path, 10};
+    auto page = generate_random_page();
+
+    // By default, every write is flushed.
+    region.write_page(page, 0);
+    region.write_page(page, 1);
+    EXPECT_EQ(region.sync_count(), 2);
+    // Nothing was written since the last flush.
+    region.sync();
+    EXPECT_EQ(region.sync_count(), 2);
+
+    region.set_sync_policy(SyncPolicy::every_n_writes(3));
+    for (auto page_id = PageID{0}; page_id < 5; ++page_id) {
+        region.write_page(page, page_id);
+    }
+    EXPECT_EQ(region.sync_count(), 3);
+    region.sync();
+    EXPECT_EQ(region.sync_count(), 4);
+
+    // A batch counts as multiple writes but is flushed once.
+    auto requests = std::vector<PageIO>{{page.data(), 2}, {page.data(), 3}, {page.data(), 4}, {page.data(), 5}};
+    region.write_pages(requests);
+    EXPECT_EQ(region.sync_count(), 5);
+
+    region.set_sync_policy(SyncPolicy::every(std::chrono::hours{1}));
+    region.write_page(page, 6);
+    EXPECT_EQ(region.sync_count(), 5);
+    region.set_sync_policy(SyncPolicy::every(std::chrono::microseconds{0}));
+    region.write_page(page, 7);
+    EXPECT_EQ(region.sync_count(), 6);
+}
+
+TEST_F(SSDDataRegionTest, GroupFlush) {
+    SSDRegion region{_ssd_path, 64};
+    region.set_sync_policy(SyncPolicy::always());
+    auto writers = std::vector<std::thread>{};
+    for (auto thread_id = 0u; thread_id < 8; ++thread_id) {
+        writers.emplace_back([&, thread_id]() {
+            auto page = generate_random_page();
+            for (auto page_id = PageID{thread_id * 8}; page_id < (thread_id + 1) * 8; ++page_id) {
+                region.write_page(page, page_id);
+            }
+        });
+    }
+    for (auto &writer : writers) {
+        writer.join();
+    }
+    // Concurrent writers share flushes, so there is at most one flush per write.
+    EXPECT_GE(region.sync_count(), 1);
+    EXPECT_LE(region.sync_count(), 64);
+    const auto sync_count = region.sync_count();
+    region.sync();
+    EXPECT_EQ(region.sync_count(), sync_count);
+}
+
+TEST_F(SSDDataRegionTest, WriteCoalescing) {
+    SSDRegion region{_ssd_path, 32};
+    auto pages = std::vector<Page>(9);
+    auto requests = std::vector<PageIO>{};
+    // Pages [2, 10) are adjacent but requested in reverse order, page 20 is separate.
+    for (auto index = uint64_t{0}; index < pages.size(); ++index) {
+        const auto page_id = index < 8 ? PageID{9 - index} : PageID{20};
+        *reinterpret_cast<uint64_t *>(pages[index].data()) = page_id * 11;
+        requests.push_back({pages[index].data(), page_id});
+    }
+    region.write_pages(requests);
+    EXPECT_EQ(region.write_call_count(), 2);
+
+    auto read_page = Page{};
+    for (const auto &request: requests) {
+        region.read_page(read_page, request.page_id);
+        EXPECT_EQ(*reinterpret_cast<uint64_t *>(read_page.data()), request.page_id * 11);
+    }
+}
+
+TEST_F(SSDDataRegionTest, SparseFile) {
+    // 16 GiB of pages, which are neither written nor reserved upfront.
+    const auto page_count = uint64_t{1} << 22;
+    SSDRegion region{_ssd_path, page_count};
+    EXPECT_EQ(std::filesystem::file_size(_ssd_path), 0);
+
+    // The file grows by an extent once a page beyond its end is allocated.
+    EXPECT_EQ(region.allocate_page_id(), 0);
+    EXPECT_EQ(std::filesystem::file_size(_ssd_path), SSDRegion::FILE_EXTENT_PAGE_COUNT * sizeof(Page));
+    for (auto page_id = PageID{1}; page_id < SSDRegion::FILE_EXTENT_PAGE_COUNT; ++page_id) {
+        region.allocate_page_id();
+    }
+    EXPECT_EQ(std::filesystem::file_size(_ssd_path), SSDRegion::FILE_EXTENT_PAGE_COUNT * sizeof(Page));
+    EXPECT_EQ(region.allocate_page_id(), SSDRegion::FILE_EXTENT_PAGE_COUNT);
+    EXPECT_EQ(std::filesystem::file_size(_ssd_path), 2 * SSDRegion::FILE_EXTENT_PAGE_COUNT * sizeof(Page));
+
+    // Pages that were never written read as zeros, even beyond the end of the file.
+    auto page = Page{};
+    std::memset(page.data(), 0xFF, sizeof(Page));
+    region.read_page(page, page_count - 1);
+    EXPECT_TRUE(std::all_of(page.data(), page.data() + sizeof(Page), [](std::byte b) { return b == std::byte{0}; }));
+
+    // A freed page does not expose its old content to the next owner.
+    auto written = generate_random_page();
+    *reinterpret_cast<uint64_t *>(written.data()) = 42;
+    region.write_page(written, 5);
+    region.read_page(page, 5);
+    EXPECT_EQ(*reinterpret_cast<uint64_t *>(page.data()), 42);
+    region.free_page_id(5);
+    EXPECT_EQ(region.allocate_page_id(), 5);
+    region.read_page(page, 5);
+    EXPECT_EQ(*reinterpret_cast<uint64_t *>(page.data()), 0);
+}
+
+TEST_F(SSDDataRegionTest, SizeClasses) {
+    const auto page_count = 64;
+    SSDRegion region{_ssd_path, page_count};
+    EXPECT_EQ(region.allocate_page_id(), 0);
+    // Larger pages are aligned to their size and their ID stores the size class.
+    const auto medium = region.allocate_page_id(PageSizeClass::SIZE_16K);
+    EXPECT_EQ(page_slot(medium), 4);
+    EXPECT_EQ(page_size_class(medium), PageSizeClass::SIZE_16K);
+    EXPECT_EQ(region.allocate_page_id(), 1);
+    const auto large = region.allocate_page_id(PageSizeClass::SIZE_64K);
+    EXPECT_EQ(page_slot(large), 16);
+    EXPECT_EQ(region.free_page_count(), page_count - 2 - 4 - 16);
+
+    // A large page is written and read with a single I/O.
+    auto data = std::vector<uint64_t>(page_size(PageSizeClass::SIZE_64K) / sizeof(uint64_t));
+    std::iota(data.begin(), data.end(), 0);
+    auto *buffer = static_cast<std::byte *>(aligned_alloc(512, page_size(PageSizeClass::SIZE_64K)));
+    std::memcpy(buffer, data.data(), page_size(PageSizeClass::SIZE_64K));
+    region.write_page(buffer, large);
+    std::memset(buffer, 0, page_size(PageSizeClass::SIZE_64K));
+    region.read_page(buffer, large);
+    EXPECT_EQ(std::memcmp(buffer, data.data(), page_size(PageSizeClass::SIZE_64K)), 0);
+    free(buffer);
+
+    region.free_page_id(medium);
+    EXPECT_EQ(region.allocate_page_id(PageSizeClass::SIZE_16K), medium);
+    // Slot 0 is taken, thus no aligned run of 64 slots is left.
+    EXPECT_EQ(region.allocate_page_id(PageSizeClass::SIZE_256K), INVALID_PAGE_ID);
+}
+
+TEST_F(SSDDataRegionTest, Reopen) {
+    const auto page_count = 100;
+    auto page = generate_random_page();
+    {
+        SSDRegion region{_ssd_path, page_count};
+        EXPECT_FALSE(region.reopened());
+        EXPECT_EQ(region.allocate_page_id(), 0);
+        EXPECT_EQ(region.allocate_page_id(), 1);
+        EXPECT_EQ(region.allocate_page_id(), 2);
+        region.write_page(page, 2);
+        region.free_page_id(1);
+        region.sync();
+    }
+
+    {
+        SSDRegion region{_ssd_path, page_count, SSDRegion::OpenMode::REOPEN};
+        EXPECT_TRUE(region.reopened());
+        EXPECT_EQ(region.free_page_count(), page_count - 2);
+        auto read_page = Page{};
+        region.read_page(read_page, 2);
+        EXPECT_EQ(memcmp(page.data(), read_page.data(), EFFECTIVE_PAGE_SIZE), 0);
+        // The lowest free page IDs are reused first.
+        EXPECT_EQ(region.allocate_page_id(), 1);
+        EXPECT_EQ(region.allocate_page_id(), 3);
+    }
+
+    {
+        // The destructor wrote back the allocations of the previous instance.
+        SSDRegion region{_ssd_path, page_count, SSDRegion::OpenMode::REOPEN};
+        EXPECT_EQ(region.free_page_count(), page_count - 4);
+    }
+
+    {
+        // A different page count does not match the free space map, thus the region is created.
+        SSDRegion region{_ssd_path, page_count / 2, SSDRegion::OpenMode::REOPEN};
+        EXPECT_FALSE(region.reopened());
+        EXPECT_EQ(region.free_page_count(), page_count / 2);
+        EXPECT_EQ(region.allocate_page_id(), 0);
+    }
+}
+
+TEST_F(SSDDataRegionTest, IoUringBatchedWriteRead) {
+    const auto page_count = 64;
+    IoUringSSDRegion region{_ssd_path, page_count, 8};
+    // Not all kernels support io_uring. In this case, the region falls back to blocking I/O and still has to work.
+    if (!region.uses_io_uring()) {
+        std::cout << "io_uring is not available, testing the fallback." << std::endl;
+    }
+
+    VolatileRegion frames{page_count};
+    EXPECT_EQ(region.register_buffers(frames.data_begin(), frames.data_end()), region.uses_io_uring());
+    EXPECT_EQ(region.uses_registered_buffers(), region.uses_io_uring());
+
+    // More requests than the queue depth, half of them with registered buffers.
+    auto pages = std::vector<Page>(page_count / 2);
+    auto requests = std::vector<PageIO>{};
+    for (auto page_id = PageID{0}; page_id < page_count; ++page_id) {
+        auto *buffer = page_id % 2 == 0 ? frames.frames()[page_id].page.data() : pages[page_id / 2].data();
+        *reinterpret_cast<uint64_t *>(buffer) = page_id * 7;
+        requests.push_back({buffer, page_id});
+    }
+    region.write_pages(requests);
+
+    auto read_pages = std::vector<Page>(page_count);
+    auto read_requests = std::vector<PageIO>{};
+    for (auto page_id = PageID{0}; page_id < page_count; ++page_id) {
+        read_requests.push_back({read_pages[page_id].data(), page_id});
+    }
+    region.read_pages(read_requests);
+    for (auto page_id = PageID{0}; page_id < page_count; ++page_id) {
+        EXPECT_EQ(*reinterpret_cast<uint64_t *>(read_pages[page_id].data()), page_id * 7);
+    }
+
+    // Reading into registered buffers.
+    auto *frame_buffer = frames.frames()[1].page.data();
+    auto frame_request = PageIO{frame_buffer, 5};
+    region.read_pages({&frame_request, 1});
+    EXPECT_EQ(*reinterpret_cast<uint64_t *>(frame_buffer), 35);
+}
+
+///////////////////////////////////////////////////////////
+//// Cooling Queue
+///////////////////////////////////////////////////////////
+
+class CoolingQueueTest : public BasicTest {
+};
+
+TEST_F(CoolingQueueTest, Fifo) {
+    VolatileRegion region{4};
+    BufferFrame *frames = region.frames();
+    CoolingQueue queue{};
+    EXPECT_TRUE(queue.empty());
+    EXPECT_EQ(queue.pop_front(), nullptr);
+
+    for (auto index = 0; index < 4; ++index) {
+        queue.push_back(frames + index);
+        EXPECT_TRUE(CoolingQueue::contains(frames + index));
+    }
+    EXPECT_EQ(queue.size(), 4);
+
+    // Remove from the middle, the front, and the back.
+    queue.remove(frames + 1);
+    EXPECT_FALSE(CoolingQueue::contains(frames + 1));
+    queue.remove(frames + 0);
+    queue.remove(frames + 3);
+    EXPECT_EQ(queue.size(), 1);
+
+    queue.push_back(frames + 1);
+    queue.push_back(frames + 0);
+    EXPECT_EQ(queue.pop_front(), frames + 2);
+    EXPECT_EQ(queue.pop_front(), frames + 1);
+    EXPECT_EQ(queue.pop_front(), frames + 0);
+    EXPECT_EQ(queue.pop_front(), nullptr);
+    EXPECT_TRUE(queue.empty());
+    EXPECT_FALSE(CoolingQueue::contains(frames + 2));
+}
+
 ///////////////////////////////////////////////////////////
 //// Buffer Manager
 ///////////////////////////////////////////////////////////
@@ -502,6 +942,603 @@ TEST_F(BufferManagerTest, FreeAndAllocatePage) {
     EXPECT_FALSE(reallocated_frame_0->is_dirty());
 }
 
+TEST_F(BufferManagerTest, MultiThreadedGetFrame) {
+    auto buffer_manager = std::make_unique<BufferManager>(std::make_unique<VolatileRegion>(_frame_count, 4),
+                                                          std::make_unique<SSDRegion>(_ssd_path, _page_count));
+    constexpr auto page_count = PageID{400};
+    auto swips = std::vector<Swip>(page_count);
+    buffer_manager->register_callbacks({nullptr, [&swips](BufferFrame *frame, ManagedDataStructure *) -> Swip & {
+        return swips[frame->page_id];
+    }});
+
+    for (auto page_id = PageID{0}; page_id < page_count; ++page_id) {
+        auto frame = buffer_manager->allocate_page();
+        ASSERT_EQ(frame->page_id, page_id);
+        swips[page_id] = Swip(frame);
+        store_u64(frame, page_id * 3);
+        frame->mark_dirty();
+    }
+
+    // More pages than frames: concurrent readers resolve hot, cooling, and evicted swips and trigger evictions.
+    auto readers = std::vector<std::thread>{};
+    auto failures = std::atomic<uint64_t>{0};
+    for (auto thread_id = 0u; thread_id < 4; ++thread_id) {
+        readers.emplace_back([&, thread_id]() {
+            std::mt19937 generator{thread_id};
+            std::uniform_int_distribution<PageID> distribution{0, page_count - 1};
+            for (auto i = 0; i < 5'000; ++i) {
+                const auto page_id = distribution(generator);
+                while (true) {
+                    auto frame = buffer_manager->get_frame(swips[page_id]);
+                    frame->latch.lock_shared();
+                    // The frame might have been evicted and reused between resolving the swip and latching it.
+                    if (frame->page_id != page_id) {
+                        frame->latch.unlock_shared();
+                        continue;
+                    }
+                    if (get_u64(frame) != page_id * 3) {
+                        ++failures;
+                    }
+                    frame->latch.unlock_shared();
+                    break;
+                }
+            }
+        });
+    }
+    for (auto &reader : readers) {
+        reader.join();
+    }
+    EXPECT_EQ(failures, 0);
+}
+
+TEST_F(BufferManagerTest, PageProvider) {
+    std::unique_ptr<BufferManager> buffer_manager = create_default_bm();
+    constexpr auto page_count = PageID{400};
+    auto swips = std::vector<Swip>(page_count);
+    buffer_manager->register_callbacks({nullptr, [&swips](BufferFrame *frame, ManagedDataStructure *) -> Swip & {
+        return swips[frame->page_id];
+    }});
+    buffer_manager->start_page_provider({32, std::chrono::microseconds{100}});
+
+    for (auto page_id = PageID{0}; page_id < page_count; ++page_id) {
+        auto frame = buffer_manager->allocate_page();
+        frame->latch.lock();
+        swips[page_id] = Swip(frame);
+        store_u64(frame, page_id * 5);
+        frame->mark_dirty();
+        frame->latch.unlock();
+    }
+
+    // The provider catches up with the allocations in the background.
+    for (auto i = 0; i < 1'000 && buffer_manager->_volatile_region->free_frame_count() < 32; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    }
+    buffer_manager->stop_page_provider();
+    EXPECT_GE(buffer_manager->_volatile_region->free_frame_count(), 32);
+
+    for (auto page_id = PageID{0}; page_id < page_count; ++page_id) {
+        EXPECT_EQ(get_u64(buffer_manager->get_frame(swips[page_id])), page_id * 5);
+    }
+}
+
+TEST_F(BufferManagerTest, BackgroundWriter) {
+    // Counts the pages written by evictions and by batches.
+    struct CountingSSDRegion : SSDRegion {
+        using SSDRegion::SSDRegion;
+
+        void write_page(const std::byte *source, PageID page_id) override {
+            ++single_writes;
+            SSDRegion::write_page(source, page_id);
+        }
+
+        void write_pages(std::span<const PageIO> requests) override {
+            batched_writes += requests.size();
+            SSDRegion::write_pages(requests);
+        }
+
+        std::atomic<uint64_t> single_writes = 0;
+        std::atomic<uint64_t> batched_writes = 0;
+    };
+
+    auto ssd_region = std::make_unique<CountingSSDRegion>(_ssd_path, _page_count);
+    auto *counting_region = ssd_region.get();
+    auto buffer_manager = std::make_unique<BufferManager>(std::make_unique<VolatileRegion>(_frame_count),
+                                                          std::move(ssd_region));
+    constexpr auto page_count = PageID{64};
+    auto swips = std::vector<Swip>(page_count);
+    buffer_manager->register_callbacks({nullptr, [&swips](BufferFrame *frame, ManagedDataStructure *) -> Swip & {
+        return swips[frame->page_id];
+    }});
+    for (auto page_id = PageID{0}; page_id < page_count; ++page_id) {
+        auto frame = buffer_manager->allocate_page();
+        frame->latch.lock();
+        swips[page_id] = Swip(frame);
+        store_u64(frame, page_id * 7);
+        frame->mark_dirty();
+        frame->latch.unlock();
+    }
+
+    // Pages [0, 16) are written back synchronously, the writer thread takes care of pages [16, 48).
+    for (auto page_id = PageID{0}; page_id < 16; ++page_id) {
+        buffer_manager->_add_eviction_candidate(swips[page_id].buffer_frame());
+    }
+    EXPECT_EQ(buffer_manager->_write_back_eviction_candidates(page_count), 16);
+    EXPECT_EQ(buffer_manager->_write_back_eviction_candidates(page_count), 0);
+    buffer_manager->start_background_writer({8, std::chrono::microseconds{100}});
+    for (auto page_id = PageID{16}; page_id < 48; ++page_id) {
+        buffer_manager->_add_eviction_candidate(swips[page_id].buffer_frame());
+    }
+    for (auto i = 0; i < 1'000 && counting_region->batched_writes < 48; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    }
+    buffer_manager->stop_background_writer();
+    EXPECT_EQ(counting_region->batched_writes, 48);
+
+    // All candidates are clean, thus evicting them does not write.
+    for (auto page_id = PageID{0}; page_id < 48; ++page_id) {
+        ASSERT_TRUE(buffer_manager->_evict_page());
+    }
+    EXPECT_EQ(counting_region->single_writes, 0);
+    for (auto page_id = PageID{0}; page_id < page_count; ++page_id) {
+        EXPECT_EQ(get_u64(buffer_manager->get_frame(swips[page_id])), page_id * 7);
+    }
+}
+
+TEST_F(BufferManagerTest, EvictionWriteCoalescing) {
+    auto ssd_region = std::make_unique<SSDRegion>(_ssd_path, _page_count);
+    auto *region = ssd_region.get();
+    auto buffer_manager = std::make_unique<BufferManager>(std::make_unique<VolatileRegion>(_frame_count),
+                                                          std::move(ssd_region));
+    constexpr auto page_count = PageID{16};
+    auto swips = std::vector<Swip>(page_count);
+    buffer_manager->register_callbacks({nullptr, [&swips](BufferFrame *frame, ManagedDataStructure *) -> Swip & {
+        return swips[frame->page_id];
+    }});
+    for (auto page_id = PageID{0}; page_id < page_count; ++page_id) {
+        auto frame = buffer_manager->allocate_page();
+        swips[page_id] = Swip(frame);
+        store_u64(frame, page_id * 13);
+        frame->mark_dirty();
+        buffer_manager->_add_eviction_candidate(frame);
+    }
+
+    // The first eviction writes all dirty candidates with a single call, the others find clean frames.
+    for (auto page_id = PageID{0}; page_id < page_count; ++page_id) {
+        ASSERT_TRUE(buffer_manager->_evict_page());
+    }
+    EXPECT_EQ(region->write_call_count(), 1);
+    for (auto page_id = PageID{0}; page_id < page_count; ++page_id) {
+        EXPECT_EQ(get_u64(buffer_manager->get_frame(swips[page_id])), page_id * 13);
+    }
+}
+
+TEST_F(BufferManagerTest, Prefetch) {
+    std::unique_ptr<BufferManager> buffer_manager = create_default_bm();
+    constexpr auto page_count = PageID{64};
+    auto swips = std::vector<Swip>(page_count);
+    buffer_manager->register_callbacks({nullptr, [&swips](BufferFrame *frame, ManagedDataStructure *) -> Swip & {
+        return swips[frame->page_id];
+    }});
+    for (auto page_id = PageID{0}; page_id < page_count; ++page_id) {
+        auto frame = buffer_manager->allocate_page();
+        swips[page_id] = Swip(frame);
+        store_u64(frame, page_id * 3);
+        frame->mark_dirty();
+    }
+    for (auto page_id = PageID{0}; page_id < page_count; ++page_id) {
+        buffer_manager->_add_eviction_candidate(swips[page_id].buffer_frame());
+        ASSERT_TRUE(buffer_manager->_evict_page());
+    }
+    ASSERT_TRUE(swips[0].is_evicted());
+
+    // Prefetched swips are swizzled immediately, get_frame waits for the reads.
+    buffer_manager->prefetch(std::span<Swip>(swips).subspan(0, page_count / 2));
+    for (auto page_id = PageID{0}; page_id < page_count / 2; ++page_id) {
+        EXPECT_TRUE(swips[page_id].is_swizzled());
+    }
+    EXPECT_TRUE(swips[page_count / 2].is_evicted());
+    buffer_manager->prefetch(swips[page_count - 1]);
+    // Prefetching a swip that is not evicted does nothing.
+    auto *frame_0 = swips[0].buffer_frame();
+    buffer_manager->prefetch(swips[0]);
+    EXPECT_EQ(swips[0].buffer_frame(), frame_0);
+
+    for (auto page_id = PageID{0}; page_id < page_count; ++page_id) {
+        auto *frame = buffer_manager->get_frame(swips[page_id]);
+        EXPECT_FALSE(frame->loading);
+        EXPECT_EQ(frame->page_id, page_id);
+        EXPECT_EQ(get_u64(frame), page_id * 3);
+    }
+}
+
+TEST_F(BufferManagerTest, GetFrames) {
+    // Counts the read batches and the reads issued outside of batches.
+    struct CountingSSDRegion : SSDRegion {
+        using SSDRegion::SSDRegion;
+
+        void read_page(std::byte *destination, PageID page_id) override {
+            single_reads += !in_batch;
+            SSDRegion::read_page(destination, page_id);
+        }
+
+        void read_pages(std::span<const PageIO> requests) override {
+            ++batches;
+            in_batch = true;
+            SSDRegion::read_pages(requests);
+            in_batch = false;
+        }
+
+        bool in_batch = false;
+        uint64_t batches = 0;
+        uint64_t single_reads = 0;
+    };
+
+    auto ssd_region = std::make_unique<CountingSSDRegion>(_ssd_path, _page_count);
+    auto *counting_region = ssd_region.get();
+    auto buffer_manager = std::make_unique<BufferManager>(std::make_unique<VolatileRegion>(_frame_count),
+                                                          std::move(ssd_region));
+    constexpr auto page_count = PageID{32};
+    auto swips = std::vector<Swip>(page_count);
+    buffer_manager->register_callbacks({nullptr, [&swips](BufferFrame *frame, ManagedDataStructure *) -> Swip & {
+        return swips[frame->page_id];
+    }});
+    for (auto page_id = PageID{0}; page_id < page_count; ++page_id) {
+        auto frame = buffer_manager->allocate_page();
+        swips[page_id] = Swip(frame);
+        store_u64(frame, page_id + 100);
+        frame->mark_dirty();
+    }
+    // Pages [0, 16) are evicted, [16, 24) are cooling, and [24, 32) are hot.
+    for (auto page_id = PageID{0}; page_id < 24; ++page_id) {
+        buffer_manager->_add_eviction_candidate(swips[page_id].buffer_frame());
+    }
+    for (auto page_id = PageID{0}; page_id < 16; ++page_id) {
+        ASSERT_TRUE(buffer_manager->_evict_page());
+    }
+    ASSERT_TRUE(swips[15].is_evicted());
+    ASSERT_TRUE(swips[16].is_cooling());
+
+    // Resolve every other swip in reverse order.
+    auto requested = std::vector<Swip *>{};
+    for (auto page_id = page_count; page_id > 0; page_id -= 2) {
+        requested.push_back(&swips[page_id - 1]);
+    }
+    auto frames = std::vector<BufferFrame *>(requested.size());
+    buffer_manager->get_frames(requested, frames);
+    EXPECT_EQ(counting_region->batches, 1);
+    EXPECT_EQ(counting_region->single_reads, 0);
+    for (uint64_t index = 0; index < requested.size(); ++index) {
+        EXPECT_TRUE(requested[index]->is_swizzled());
+        EXPECT_EQ(frames[index], requested[index]->buffer_frame());
+        EXPECT_EQ(get_u64(frames[index]), frames[index]->page_id + 100);
+    }
+}
+
+TEST_F(BufferManagerTest, ScanResistance) {
+    auto buffer_manager = std::make_unique<BufferManager>(std::make_unique<VolatileRegion>(_frame_count),
+                                                          std::make_unique<SSDRegion>(_ssd_path, 2048));
+    constexpr auto scan_page_count = PageID{1000};
+    constexpr auto hot_page_count = PageID{100};
+    auto swips = std::vector<Swip>(scan_page_count + hot_page_count);
+    buffer_manager->register_callbacks({nullptr, [&swips](BufferFrame *frame, ManagedDataStructure *) -> Swip & {
+        return swips[frame->page_id];
+    }});
+
+    // Pages [0, 1000) are scanned. They are written once and evicted.
+    for (auto page_id = PageID{0}; page_id < scan_page_count; ++page_id) {
+        auto frame = buffer_manager->allocate_page();
+        swips[frame->page_id] = Swip(frame);
+        store_u64(frame, frame->page_id);
+        frame->mark_dirty();
+        buffer_manager->_add_eviction_candidate(frame);
+        ASSERT_TRUE(buffer_manager->_evict_page());
+    }
+    // Pages [1000, 1100) are the hot set of another workload.
+    for (auto page_id = PageID{0}; page_id < hot_page_count; ++page_id) {
+        auto frame = buffer_manager->allocate_page();
+        ASSERT_EQ(frame->page_id, scan_page_count + page_id);
+        swips[frame->page_id] = Swip(frame);
+    }
+
+    for (auto page_id = PageID{0}; page_id < scan_page_count; ++page_id) {
+        auto *frame = buffer_manager->get_frame(swips[page_id], AccessMode::SCAN);
+        EXPECT_EQ(get_u64(frame), page_id);
+    }
+    for (auto page_id = scan_page_count; page_id < scan_page_count + hot_page_count; ++page_id) {
+        EXPECT_TRUE(swips[page_id].is_swizzled());
+    }
+
+    // A normal access of a scanned page makes it hot.
+    auto *frame = buffer_manager->get_frame(swips[scan_page_count - 1]);
+    EXPECT_EQ(get_u64(frame), scan_page_count - 1);
+    EXPECT_TRUE(swips[scan_page_count - 1].is_swizzled());
+}
+
+TEST_F(BufferManagerTest, SizeClasses) {
+    auto buffer_manager = std::make_unique<BufferManager>(std::make_unique<VolatileRegion>(
+            std::array<uint64_t, PAGE_SIZE_CLASS_COUNT>{16, 0, 0, 2}), std::make_unique<SSDRegion>(_ssd_path, 1024));
+    auto swips = std::unordered_map<PageID, Swip>{};
+    buffer_manager->register_callbacks({nullptr, [&swips](BufferFrame *frame, ManagedDataStructure *) -> Swip & {
+        return swips[frame->page_id];
+    }});
+
+    // Allocating more large pages than large frames evicts large pages, even if small frames are free.
+    auto page_ids = std::vector<PageID>{};
+    for (auto index = 0; index < 4; ++index) {
+        auto *frame = buffer_manager->allocate_page(PageSizeClass::SIZE_256K);
+        ASSERT_EQ(frame->size_class, PageSizeClass::SIZE_256K);
+        frame->as<uint64_t>()[0] = index;
+        frame->as<uint64_t>()[page_size(PageSizeClass::SIZE_256K) / sizeof(uint64_t) - 1] = index * 3;
+        frame->mark_dirty();
+        swips[frame->page_id] = Swip(frame);
+        page_ids.push_back(frame->page_id);
+    }
+    EXPECT_EQ(buffer_manager->_volatile_region->free_frame_count(PageSizeClass::SIZE_4K), 16);
+
+    for (auto index = 0; index < 4; ++index) {
+        auto *frame = buffer_manager->get_frame(swips[page_ids[index]]);
+        EXPECT_EQ(frame->size_class, PageSizeClass::SIZE_256K);
+        EXPECT_EQ(frame->as<uint64_t>()[0], index);
+        EXPECT_EQ(frame->as<uint64_t>()[page_size(PageSizeClass::SIZE_256K) / sizeof(uint64_t) - 1], index * 3);
+    }
+}
+
+TEST_F(BufferManagerTest, Statistics) {
+    if constexpr (!COLLECT_STATISTICS) {
+        GTEST_SKIP();
+    }
+    auto buffer_manager = std::make_unique<BufferManager>(std::make_unique<VolatileRegion>(_frame_count),
+                                                          std::make_unique<SSDRegion>(_ssd_path, _page_count));
+    constexpr auto page_count = PageID{16};
+    auto swips = std::vector<Swip>(page_count);
+    buffer_manager->register_callbacks({nullptr, [&swips](BufferFrame *frame, ManagedDataStructure *) -> Swip & {
+        return swips[frame->page_id];
+    }});
+    for (auto page_id = PageID{0}; page_id < page_count; ++page_id) {
+        auto frame = buffer_manager->allocate_page();
+        swips[page_id] = Swip(frame);
+        frame->mark_dirty();
+        buffer_manager->_add_eviction_candidate(frame);
+    }
+    // One page is rescued from the cooling stage, the others are evicted with a single write and loaded again.
+    buffer_manager->get_frame(swips[0]);
+    for (auto page_id = PageID{1}; page_id < page_count; ++page_id) {
+        ASSERT_TRUE(buffer_manager->_evict_page());
+    }
+    for (auto page_id = PageID{1}; page_id < page_count; ++page_id) {
+        buffer_manager->get_frame(swips[page_id]);
+    }
+
+    // Every thread counts its hits separately.
+    auto threads = std::vector<std::thread>{};
+    for (auto thread = 0; thread < 4; ++thread) {
+        threads.emplace_back([&buffer_manager, &swips]() {
+            for (auto page_id = PageID{0}; page_id < page_count; ++page_id) {
+                buffer_manager->get_frame(swips[page_id]);
+            }
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+
+    const auto statistics = buffer_manager->statistics();
+    EXPECT_EQ(statistics.hits, 4 * page_count);
+    EXPECT_EQ(statistics.cooling_rescues, 1);
+    EXPECT_EQ(statistics.misses, page_count - 1);
+    EXPECT_EQ(statistics.pages_cooled, page_count);
+    EXPECT_EQ(statistics.evictions, page_count - 1);
+    EXPECT_EQ(statistics.eviction_flushes, 1);
+    EXPECT_EQ(statistics.pages_read, page_count - 1);
+    EXPECT_EQ(statistics.bytes_read, (page_count - 1) * PAGE_SIZE);
+    EXPECT_EQ(statistics.pages_written, page_count - 1);
+    EXPECT_EQ(statistics.bytes_written, (page_count - 1) * PAGE_SIZE);
+    EXPECT_EQ(statistics.read_latency.count(), page_count - 1);
+    EXPECT_EQ(statistics.write_latency.count(), 1);
+    EXPECT_EQ(statistics.miss_latency.count(), page_count - 1);
+    EXPECT_GE(statistics.miss_latency.percentile(0.5), statistics.read_latency.percentile(0.01));
+    EXPECT_NE(statistics.to_text().find("misses: 15\n"), std::string::npos);
+    const auto json = statistics.to_json();
+    EXPECT_EQ(json.front(), '{');
+    EXPECT_EQ(json.back(), '}');
+    EXPECT_NE(json.find("\"evictions\":15,"), std::string::npos);
+    EXPECT_NE(json.find("\"write_latency_ns\":{\"count\":1,"), std::string::npos);
+}
+
+TEST_F(BufferManagerTest, AdaptiveCoolingStage) {
+    auto config = CoolingStageConfig{};
+    config.adaptive = true;
+    auto buffer_manager = std::make_unique<BufferManager>(std::make_unique<VolatileRegion>(_frame_count),
+                                                          std::make_unique<SSDRegion>(_ssd_path, 4096), config);
+    auto swips = std::vector<Swip>(4096);
+    buffer_manager->register_callbacks({nullptr, [&swips](BufferFrame *frame, ManagedDataStructure *) -> Swip & {
+        return swips[frame->page_id];
+    }});
+    const auto initial_target = buffer_manager->cooling_target();
+    EXPECT_EQ(initial_target, static_cast<uint64_t>(_frame_count * SHARE_COOLING_PAGES));
+
+    // All pages fit into memory and are accessed again, thus every cooling page is rescued and the target shrinks.
+    constexpr auto hot_page_count = PageID{200};
+    for (auto page_id = PageID{0}; page_id < hot_page_count; ++page_id) {
+        swips[page_id] = Swip(buffer_manager->allocate_page());
+    }
+    for (auto round = 0; round < 20; ++round) {
+        for (auto page_id = PageID{0}; page_id < hot_page_count; ++page_id) {
+            buffer_manager->get_frame(swips[page_id]);
+        }
+    }
+    const auto shrunk_target = buffer_manager->cooling_target();
+    EXPECT_LT(shrunk_target, initial_target);
+
+    // New pages evict cooling pages that are never accessed again, thus the target grows.
+    for (auto page_id = hot_page_count; page_id < swips.size(); ++page_id) {
+        auto *frame = buffer_manager->allocate_page();
+        swips[frame->page_id] = Swip(frame);
+    }
+    EXPECT_GT(buffer_manager->cooling_target(), shrunk_target);
+    EXPECT_LE(buffer_manager->cooling_target(), static_cast<uint64_t>(_frame_count * config.max_share_cooling_pages));
+    if constexpr (COLLECT_STATISTICS) {
+        const auto statistics = buffer_manager->statistics();
+        EXPECT_GT(statistics.cooling_target_decreases, 0);
+        EXPECT_GT(statistics.cooling_target_increases, 0);
+        EXPECT_EQ(statistics.cooling_target, buffer_manager->cooling_target());
+    }
+}
+
+TEST_F(BufferManagerTest, AccessTrace) {
+    auto buffer_manager = std::make_unique<BufferManager>(std::make_unique<VolatileRegion>(_frame_count),
+                                                          std::make_unique<MemoryRegion>(_ssd_path, _page_count));
+    auto swips = std::vector<Swip>(2);
+    buffer_manager->register_callbacks({nullptr, [&swips](BufferFrame *frame, ManagedDataStructure *) -> Swip & {
+        return swips[frame->page_id];
+    }});
+    const auto trace_path = _base_dir_ssd / "trace";
+    buffer_manager->start_trace(trace_path);
+    for (auto page_id = PageID{0}; page_id < 2; ++page_id) {
+        auto frame = buffer_manager->allocate_page();
+        swips[page_id] = Swip(frame);
+        store_u64(frame, page_id + 7);
+        frame->mark_dirty();
+    }
+    buffer_manager->get_frame(swips[0]);
+    buffer_manager->_add_eviction_candidate(swips[0].buffer_frame());
+    buffer_manager->_add_eviction_candidate(swips[1].buffer_frame());
+    buffer_manager->get_frame(swips[0], AccessMode::SCAN);
+    ASSERT_TRUE(buffer_manager->_evict_page());
+    // The page is read back from the memory region.
+    EXPECT_EQ(get_u64(buffer_manager->get_frame(swips[0])), 7);
+    buffer_manager->free_page(buffer_manager->get_frame(swips[1]));
+    buffer_manager->stop_trace();
+
+    auto records = std::vector<TraceRecord>{};
+    ASSERT_TRUE(read_trace(trace_path, records));
+    const auto expected = std::vector<std::tuple<PageID, TraceOperation, TraceState>>{
+            {0, TraceOperation::ALLOCATE, TraceState::HOT},
+            {1, TraceOperation::ALLOCATE, TraceState::HOT},
+            {0, TraceOperation::GET, TraceState::HOT},
+            {0, TraceOperation::SCAN, TraceState::COOLING},
+            {0, TraceOperation::GET, TraceState::EVICTED},
+            {1, TraceOperation::GET, TraceState::COOLING},
+            {1, TraceOperation::FREE, TraceState::HOT}};
+    ASSERT_EQ(records.size(), expected.size());
+    for (uint64_t index = 0; index < records.size(); ++index) {
+        EXPECT_EQ(std::tuple(records[index].page_id, records[index].operation, records[index].state), expected[index]);
+    }
+}
+
+///////////////////////////////////////////////////////////
+//// B+-Tree
+///////////////////////////////////////////////////////////
+
+class BTreeTest : public BasicTest {
+};
+
+TEST_F(BTreeTest, InsertLookupRemove) {
+    std::unique_ptr<BufferManager> buffer_manager = create_default_bm();
+    BTree tree{*buffer_manager};
+    EXPECT_EQ(tree.height(), 1);
+    EXPECT_FALSE(tree.lookup(1).has_value());
+
+    // Random order, every key is inserted once.
+    constexpr auto key_count = uint64_t{20'000};
+    auto keys = std::vector<uint64_t>(key_count);
+    std::iota(keys.begin(), keys.end(), 0);
+    std::shuffle(keys.begin(), keys.end(), std::mt19937_64{42});
+    for (const auto key: keys) {
+        ASSERT_TRUE(tree.insert(key, key * 2));
+    }
+    EXPECT_FALSE(tree.insert(keys[0], 0));
+    EXPECT_EQ(tree.height(), 2);
+
+    for (auto key = uint64_t{0}; key < key_count; ++key) {
+        ASSERT_EQ(tree.lookup(key), key * 2);
+    }
+    EXPECT_FALSE(tree.lookup(key_count).has_value());
+
+    for (auto key = uint64_t{0}; key < key_count; key += 2) {
+        ASSERT_TRUE(tree.remove(key));
+    }
+    EXPECT_FALSE(tree.remove(0));
+    for (auto key = uint64_t{0}; key < key_count; ++key) {
+        ASSERT_EQ(tree.lookup(key).has_value(), key % 2 == 1);
+    }
+}
+
+TEST_F(BTreeTest, EvictNodes) {
+    // 20'000 entries take about 120 leaves, which do not fit into 64 frames.
+    auto buffer_manager = std::make_unique<BufferManager>(std::make_unique<VolatileRegion>(64),
+                                                          std::make_unique<SSDRegion>(_ssd_path, _page_count));
+    buffer_manager->_ssd_region->set_sync_policy(SyncPolicy::every_n_writes(1024));
+    BTree tree{*buffer_manager};
+    constexpr auto key_count = uint64_t{20'000};
+    for (auto key = uint64_t{0}; key < key_count; ++key) {
+        ASSERT_TRUE(tree.insert(key * 7 % key_count, key));
+    }
+    EXPECT_GT(_page_count - buffer_manager->_ssd_region->free_page_count(), 64);
+
+    for (auto key = uint64_t{0}; key < key_count; ++key) {
+        ASSERT_EQ(tree.lookup(key * 7 % key_count), key);
+    }
+
+    // A scan visits every leaf in key order.
+    auto expected = uint64_t{100};
+    tree.scan(100, [&expected](uint64_t key, uint64_t) {
+        EXPECT_EQ(key, expected);
+        ++expected;
+        return true;
+    });
+    EXPECT_EQ(expected, key_count);
+
+    // The scan stops when the function returns false.
+    auto scanned = uint64_t{0};
+    tree.scan(0, [&scanned](uint64_t, uint64_t) { return ++scanned < 1'000; });
+    EXPECT_EQ(scanned, 1'000);
+}
+
+TEST_F(BTreeTest, TypeErasedCallbacks) {
+    // The tree registers its static callbacks, the type-erased ones have to cool and evict the same nodes.
+    auto buffer_manager = std::make_unique<BufferManager>(std::make_unique<VolatileRegion>(64),
+                                                          std::make_unique<SSDRegion>(_ssd_path, _page_count));
+    BTree tree{*buffer_manager};
+    buffer_manager->register_callbacks(BTree::callbacks());
+    constexpr auto key_count = uint64_t{20'000};
+    for (auto key = uint64_t{0}; key < key_count; ++key) {
+        ASSERT_TRUE(tree.insert(key * 7 % key_count, key));
+    }
+    EXPECT_GT(_page_count - buffer_manager->_ssd_region->free_page_count(), 64);
+    for (auto key = uint64_t{0}; key < key_count; ++key) {
+        ASSERT_EQ(tree.lookup(key * 7 % key_count), key);
+    }
+}
+
+TEST_F(BTreeTest, MultiThreaded) {
+    auto buffer_manager = std::make_unique<BufferManager>(std::make_unique<VolatileRegion>(64),
+                                                          std::make_unique<SSDRegion>(_ssd_path, _page_count));
+    buffer_manager->_ssd_region->set_sync_policy(SyncPolicy::every_n_writes(1024));
+    BTree tree{*buffer_manager};
+    constexpr auto thread_count = uint64_t{4};
+    constexpr auto keys_per_thread = uint64_t{5'000};
+
+    // Every thread inserts its own keys interleaved with the other threads' keys, and reads them back.
+    auto threads = std::vector<std::thread>{};
+    for (auto thread = uint64_t{0}; thread < thread_count; ++thread) {
+        threads.emplace_back([&tree, thread]() {
+            for (auto index = uint64_t{0}; index < keys_per_thread; ++index) {
+                const auto key = index * thread_count + thread;
+                EXPECT_TRUE(tree.insert(key, key + 1));
+                EXPECT_EQ(tree.lookup(key), key + 1);
+            }
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+
+    for (auto key = uint64_t{0}; key < thread_count * keys_per_thread; ++key) {
+        ASSERT_EQ(tree.lookup(key), key + 1);
+    }
+}
+
 // does not work -> we need to add a data structure with callback
 //TEST_F(BufferManagerTest, EvictionCandidate) {
 //    std::unique_ptr<BufferManager> buffer_manager = create_default_bm();
@@ -0,0 +1,227 @@
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "buffer_manager.hpp"
+
+// YCSB-style workloads against the buffer manager. The data set consists of DATA_SET_SIZE bytes of pages that are
+// referenced by an array of swips, and the buffer pool holds a given share of it (the benchmarks' first argument, in
+// percent). Besides the throughput (items_per_second), every benchmark reports the share of accesses that found their
+// page in memory (hit_rate) and latency percentiles per access in nanoseconds. Percentiles are computed per thread and
+// averaged over all threads. Measuring the latency adds two clock reads to every access.
+
+namespace {
+
+constexpr uint64_t DATA_SET_SIZE = 128 * MiB;
+constexpr uint64_t PAGE_COUNT = DATA_SET_SIZE / EFFECTIVE_PAGE_SIZE;
+constexpr uint64_t VALUES_PER_PAGE = EFFECTIVE_PAGE_SIZE / sizeof(uint64_t);
+
+enum Distribution : int64_t { UNIFORM = 0, ZIPFIAN = 1 };
+
+std::unique_ptr<BufferManager> buffer_manager;
+std::vector<Swip> swips;
+
+// Zipfian distribution over [0, n) as generated by YCSB (Gray et al., "Quickly generating billion-record synthetic
+// databases"). Like YCSB's scrambled Zipfian generator, the ranks are hashed, so that the hot pages are spread over the
+// data set instead of being adjacent.
+class ZipfianDistribution {
+ public:
+  explicit ZipfianDistribution(uint64_t n, double theta = 0.99) : _n(n), _theta(theta) {
+    double zeta_n = 0;
+    for (uint64_t i = 1; i <= n; ++i) {
+      zeta_n += 1 / std::pow(static_cast<double>(i), theta);
+    }
+    _zeta_n = zeta_n;
+    _alpha = 1 / (1 - theta);
+    _eta = (1 - std::pow(2.0 / n, 1 - theta)) / (1 - (1 + 1 / std::pow(2.0, theta)) / zeta_n);
+  }
+
+  template <typename Generator>
+  uint64_t operator()(Generator &generator) const {
+    const auto u = std::uniform_real_distribution<double>(0, 1)(generator);
+    const auto uz = u * _zeta_n;
+    uint64_t rank;
+    if (uz < 1) {
+      rank = 0;
+    } else if (uz < 1 + std::pow(0.5, _theta)) {
+      rank = 1;
+    } else {
+      rank = static_cast<uint64_t>(_n * std::pow(_eta * u - _eta + 1, _alpha));
+    }
+    return _scramble(std::min(rank, _n - 1)) % _n;
+  }
+
+ private:
+  // FNV-1a hash of the rank.
+  static uint64_t _scramble(uint64_t rank) {
+    uint64_t hash = 0xcbf29ce484222325;
+    for (uint64_t byte = 0; byte < sizeof(rank); ++byte) {
+      hash ^= (rank >> (8 * byte)) & 0xff;
+      hash *= 0x100000001b3;
+    }
+    return hash;
+  }
+
+  uint64_t _n;
+  double _theta;
+  double _zeta_n;
+  double _alpha;
+  double _eta;
+};
+
+// Returns a generator of page indices with the given distribution.
+std::function<uint64_t(std::mt19937_64 &)> page_distribution(int64_t distribution) {
+  if (distribution == ZIPFIAN) {
+    // Computing zeta is expensive, thus all threads share one distribution.
+    static const auto zipfian = ZipfianDistribution(PAGE_COUNT);
+    return [](std::mt19937_64 &generator) { return zipfian(generator); };
+  }
+  return [](std::mt19937_64 &generator) {
+    return std::uniform_int_distribution<uint64_t>(0, PAGE_COUNT - 1)(generator);
+  };
+}
+
+// Creates a buffer pool that holds the share of the data set given by the first argument and writes all pages.
+void create_buffer_manager(const benchmark::State &state) {
+  const auto pool_percent = static_cast<uint64_t>(state.range(0));
+  const auto ssd_path = std::filesystem::temp_directory_path() / "bm_bench.ssd";
+  buffer_manager = std::make_unique<BufferManager>(
+          std::make_unique<VolatileRegion>(std::max<uint64_t>(PAGE_COUNT * pool_percent / 100, 64)),
+          std::make_unique<SSDRegion>(ssd_path, PAGE_COUNT + PAGE_COUNT / 8));
+  buffer_manager->_ssd_region->set_sync_policy(SyncPolicy::every_n_writes(1024));
+  swips = std::vector<Swip>(PAGE_COUNT);
+  buffer_manager->register_callbacks({nullptr, [](BufferFrame *frame, ManagedDataStructure *) -> Swip & {
+    return swips[frame->page_id];
+  }});
+
+  for (uint64_t page = 0; page < PAGE_COUNT; ++page) {
+    auto *frame = buffer_manager->allocate_page_latched();
+    auto *values = frame->as<uint64_t>();
+    for (uint64_t slot = 0; slot < VALUES_PER_PAGE; ++slot) {
+      values[slot] = page * VALUES_PER_PAGE + slot;
+    }
+    frame->mark_dirty();
+    swips[frame->page_id] = Swip(frame);
+    frame->latch.unlock();
+  }
+}
+
+void destroy_buffer_manager(const benchmark::State &) {
+  buffer_manager.reset();
+  swips.clear();
+}
+
+// Per-thread measurements of a benchmark run.
+struct Measurements {
+  LatencyHistogram latencies{};
+  uint64_t hits = 0;
+  uint64_t accesses = 0;
+
+  void report(benchmark::State &state) const {
+    state.SetItemsProcessed(accesses);
+    state.counters["hit_rate"] = benchmark::Counter(accesses ? static_cast<double>(hits) / accesses : 0,
+                                                    benchmark::Counter::kAvgThreads);
+    state.counters["p50_ns"] = benchmark::Counter(latencies.percentile(0.5), benchmark::Counter::kAvgThreads);
+    state.counters["p99_ns"] = benchmark::Counter(latencies.percentile(0.99), benchmark::Counter::kAvgThreads);
+    state.counters["p999_ns"] = benchmark::Counter(latencies.percentile(0.999), benchmark::Counter::kAvgThreads);
+  }
+};
+
+// Accesses a value of the page under the frame's latch, retrying if the frame was evicted before we latched it. A
+// write increments the value.
+uint64_t access(uint64_t page, uint64_t slot, bool write, AccessMode mode, Measurements &measurements) {
+  const auto start = std::chrono::steady_clock::now();
+  // Only a hint, the page might be evicted or loaded concurrently.
+  measurements.hits += !swips[page].is_evicted();
+  ++measurements.accesses;
+  uint64_t value;
+  while (true) {
+    auto *frame = buffer_manager->get_frame(swips[page], mode);
+    if (write) {
+      frame->latch.lock();
+    } else {
+      frame->latch.lock_shared();
+    }
+    if (frame->page_id == page) {
+      if (write) {
+        value = ++frame->as<uint64_t>()[slot];
+        frame->mark_dirty();
+        frame->latch.unlock();
+      } else {
+        value = frame->as<uint64_t>()[slot];
+        frame->latch.unlock_shared();
+      }
+      break;
+    }
+    if (write) {
+      frame->latch.unlock();
+    } else {
+      frame->latch.unlock_shared();
+    }
+  }
+  const auto end = std::chrono::steady_clock::now();
+  measurements.latencies.record(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+  return value;
+}
+
+}  // namespace
+
+// Point lookups of single values (YCSB C). Arguments: pool size in percent of the data set, distribution (0 = uniform,
+// 1 = Zipfian).
+static void BM_PointLookup(benchmark::State &state) {
+  auto generator = std::mt19937_64(state.thread_index());
+  auto next_page = page_distribution(state.range(1));
+  auto slot = std::uniform_int_distribution<uint64_t>(0, VALUES_PER_PAGE - 1);
+  auto measurements = Measurements{};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(access(next_page(generator), slot(generator), false, AccessMode::NORMAL, measurements));
+  }
+  measurements.report(state);
+}
+
+// Mix of lookups and read-modify-writes of single values (YCSB A with 50% and B with 5% updates). Arguments: pool size
+// in percent, distribution, update share in percent.
+static void BM_ReadWriteMix(benchmark::State &state) {
+  auto generator = std::mt19937_64(state.thread_index());
+  auto next_page = page_distribution(state.range(1));
+  auto slot = std::uniform_int_distribution<uint64_t>(0, VALUES_PER_PAGE - 1);
+  auto percent = std::uniform_int_distribution<int64_t>(0, 99);
+  auto measurements = Measurements{};
+  for (auto _ : state) {
+    const bool write = percent(generator) < state.range(2);
+    benchmark::DoNotOptimize(access(next_page(generator), slot(generator), write, AccessMode::NORMAL, measurements));
+  }
+  measurements.report(state);
+}
+
+// Sequential scans over the whole data set, one value per page. Arguments: pool size in percent, access mode
+// (0 = normal, 1 = scan).
+static void BM_SequentialScan(benchmark::State &state) {
+  const auto mode = state.range(1) == 0 ? AccessMode::NORMAL : AccessMode::SCAN;
+  auto measurements = Measurements{};
+  for (auto _ : state) {
+    uint64_t sum = 0;
+    for (uint64_t page = 0; page < PAGE_COUNT; ++page) {
+      sum += access(page, 0, false, mode, measurements);
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  measurements.report(state);
+  state.SetBytesProcessed(state.iterations() * DATA_SET_SIZE);
+}
+
+BENCHMARK(BM_PointLookup)->ArgsProduct({{10, 25, 50, 100}, {UNIFORM, ZIPFIAN}})->ArgNames({"pool%", "zipf"})
+    ->Threads(1)->Threads(4)->UseRealTime()->Setup(create_buffer_manager)->Teardown(destroy_buffer_manager);
+BENCHMARK(BM_ReadWriteMix)->ArgsProduct({{10, 25, 50, 100}, {UNIFORM, ZIPFIAN}, {5, 50}})
+    ->ArgNames({"pool%", "zipf", "update%"})->Threads(1)->Threads(4)->UseRealTime()->Setup(create_buffer_manager)
+    ->Teardown(destroy_buffer_manager);
+BENCHMARK(BM_SequentialScan)->ArgsProduct({{10, 50, 100}, {0, 1}})->ArgNames({"pool%", "scan_mode"})
+    ->UseRealTime()->Setup(create_buffer_manager)->Teardown(destroy_buffer_manager);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,114 @@
+#include <benchmark/benchmark.h>
+
+#include <filesystem>
+#include <memory>
+#include <random>
+
+#include "btree.hpp"
+#include "buffer_manager.hpp"
+#include "memory_region.hpp"
+
+// Compares the buffer manager's type-erased callbacks (`Callbacks`, which call through `std::function`) with the static
+// callbacks of a data structure type (see `ProvidesCallbacks`). Pages are kept in memory (see `MemoryRegion`), thus the
+// benchmarks measure CPU time only.
+
+namespace {
+
+enum Dispatch : int64_t { STATIC = 0, TYPE_ERASED = 1 };
+
+constexpr uint64_t KEY_COUNT = 1'000'000;
+
+// A tree of KEY_COUNT keys inserted in ascending order, i.e., with half-full leaves.
+struct Tree {
+  std::unique_ptr<BufferManager> buffer_manager;
+  std::unique_ptr<BTree> tree;
+};
+
+// Returns the number of pages of the tree, which is built with a pool that holds all of them.
+uint64_t tree_page_count() {
+  static const uint64_t page_count = [] {
+    constexpr uint64_t pool_frame_count = 16'384;
+    auto buffer_manager = BufferManager(
+        std::make_unique<VolatileRegion>(pool_frame_count),
+        std::make_unique<MemoryRegion>(std::filesystem::temp_directory_path() / "callback_benchmark.ssd",
+                                       2 * pool_frame_count));
+    auto tree = BTree(buffer_manager);
+    for (uint64_t key = 0; key < KEY_COUNT; ++key) {
+      tree.insert(key, key);
+    }
+    return pool_frame_count - buffer_manager._volatile_region->free_frame_count();
+  }();
+  return page_count;
+}
+
+// Builds the tree with a pool that holds the given share of its pages and registers the callbacks of the dispatch.
+Tree build_tree(uint64_t pool_percent, int64_t dispatch) {
+  const auto page_count = tree_page_count();
+  auto result = Tree{};
+  result.buffer_manager = std::make_unique<BufferManager>(
+      std::make_unique<VolatileRegion>(std::max<uint64_t>(page_count * pool_percent / 100, 64)),
+      std::make_unique<MemoryRegion>(std::filesystem::temp_directory_path() / "callback_benchmark.ssd",
+                                     2 * page_count + SSDRegion::FILE_EXTENT_PAGE_COUNT));
+  result.tree = std::make_unique<BTree>(*result.buffer_manager);
+  if (dispatch == TYPE_ERASED) {
+    result.buffer_manager->register_callbacks(BTree::callbacks());
+  }
+  for (uint64_t key = 0; key < KEY_COUNT; ++key) {
+    result.tree->insert(key, key);
+  }
+  return result;
+}
+
+// Returns the frame of an inner node, i.e., the parent of a leaf.
+BufferFrame *inner_node(BufferManager &buffer_manager) {
+  for (uint64_t index = 0;; ++index) {
+    auto *frame = buffer_manager._volatile_region->frame_at(index);
+    if (frame->page_id != INVALID_PAGE_ID && frame->parent_frame != nullptr) {
+      return frame->parent_frame;
+    }
+  }
+}
+
+}  // namespace
+
+// Iterates all child swips of an inner node, as the buffer manager does to check for resident children. Arguments:
+// dispatch (0 = static, 1 = type-erased).
+static void BM_IterateChildren(benchmark::State &state) {
+  auto tree = build_tree(100, STATIC);
+  auto *frame = inner_node(*tree.buffer_manager);
+  const auto callbacks = BTree::callbacks();
+  uint64_t resident = 0;
+  for (auto _ : state) {
+    auto count_resident = [&resident](Swip &swip) {
+      resident += !swip.is_evicted();
+      return false;
+    };
+    if (state.range(0) == STATIC) {
+      BTree::iterate_children(frame, count_resident);
+    } else {
+      callbacks.iterate_children(frame, count_resident);
+    }
+    benchmark::DoNotOptimize(resident);
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(resident));
+}
+BENCHMARK(BM_IterateChildren)->ArgName("dispatch")->Arg(STATIC)->Arg(TYPE_ERASED);
+
+// Random point lookups in the tree, whose misses make the buffer manager cool and evict nodes through the callbacks.
+// Arguments: pool size in percent of the tree's pages, dispatch.
+static void BM_TreeLookup(benchmark::State &state) {
+  auto tree = build_tree(static_cast<uint64_t>(state.range(0)), state.range(1));
+  auto generator = std::mt19937_64(42);
+  auto key = std::uniform_int_distribution<uint64_t>(0, KEY_COUNT - 1);
+  const auto statistics_before = tree.buffer_manager->statistics();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(tree.tree->lookup(key(generator)));
+  }
+  const auto statistics = tree.buffer_manager->statistics();
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+  state.counters["evictions"] = benchmark::Counter(
+      static_cast<double>(statistics.evictions - statistics_before.evictions), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_TreeLookup)->ArgNames({"pool%", "dispatch"})->ArgsProduct({{25, 50, 100}, {STATIC, TYPE_ERASED}});
+
+BENCHMARK_MAIN();
@@ -0,0 +1,154 @@
+#include <benchmark/benchmark.h>
+
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "buffer_manager.hpp"
+
+// Benchmarks of the buffer manager that are built once per compile-time configuration (see `add_config_benchmark` in
+// CMakeLists.txt). Every configuration uses the same memory budget and data set size, so the results of the
+// config_benchmark_* executables can be compared directly, e.g., with Google Benchmark's tools/compare.py.
+
+namespace {
+
+constexpr uint64_t MEMORY_BUDGET = 16 * MiB;
+constexpr uint64_t DATA_SET_SIZE = 64 * MiB;
+constexpr uint64_t VALUE_COUNT = DATA_SET_SIZE / sizeof(uint64_t);
+constexpr uint64_t VALUES_PER_PAGE = EFFECTIVE_PAGE_SIZE / sizeof(uint64_t);
+constexpr uint64_t PAGE_COUNT = VALUE_COUNT / VALUES_PER_PAGE;
+constexpr uint64_t FRAME_COUNT = MEMORY_BUDGET / VolatileRegion::frame_memory_size(PageSizeClass::SIZE_4K);
+
+std::unique_ptr<BufferManager> buffer_manager;
+std::vector<Swip> swips;
+
+std::string config_label() {
+  return "page_size=" + std::to_string(PAGE_SIZE) + " alignment=" + std::to_string(PAGE_ALIGNMENT) +
+         " tag_bits=" + std::to_string(SWIP_TAG_BITS) + " cooling_share=" + std::to_string(SHARE_COOLING_PAGES) +
+         " layout=" + (DECOUPLED_FRAMES ? "decoupled" : "interleaved");
+}
+
+void create_buffer_manager(const benchmark::State &) {
+  const auto ssd_path = std::filesystem::temp_directory_path() / "config_benchmark.ssd";
+  buffer_manager = std::make_unique<BufferManager>(std::make_unique<VolatileRegion>(FRAME_COUNT),
+                                                   std::make_unique<SSDRegion>(ssd_path, 2 * PAGE_COUNT));
+  swips = std::vector<Swip>(PAGE_COUNT);
+  buffer_manager->register_callbacks({nullptr, [](BufferFrame *frame, ManagedDataStructure *) -> Swip & {
+    return swips[frame->page_id];
+  }});
+  buffer_manager->_ssd_region->set_sync_policy(SyncPolicy::every_n_writes(1024));
+
+  for (uint64_t page = 0; page < PAGE_COUNT; ++page) {
+    auto *frame = buffer_manager->allocate_page();
+    frame->latch.lock();
+    auto *values = frame->as<uint64_t>();
+    for (uint64_t slot = 0; slot < VALUES_PER_PAGE; ++slot) {
+      values[slot] = page * VALUES_PER_PAGE + slot;
+    }
+    frame->mark_dirty();
+    swips[frame->page_id] = Swip(frame);
+    frame->latch.unlock();
+  }
+}
+
+void destroy_buffer_manager(const benchmark::State &) {
+  buffer_manager.reset();
+  swips.clear();
+}
+
+// Returns the value with the given index under the frame's shared latch.
+uint64_t read_value(uint64_t index) {
+  const auto page = index / VALUES_PER_PAGE;
+  while (true) {
+    auto *frame = buffer_manager->get_frame(swips[page]);
+    frame->latch.lock_shared();
+    if (frame->page_id == page) {
+      const auto value = frame->as<uint64_t>()[index % VALUES_PER_PAGE];
+      frame->latch.unlock_shared();
+      return value;
+    }
+    // The frame was evicted before we latched it.
+    frame->latch.unlock_shared();
+  }
+}
+
+}  // namespace
+
+// Reads uniformly distributed values. Four times more data than frames, thus most reads of larger pages miss.
+static void BM_RandomRead(benchmark::State &state) {
+  auto random_generator = std::mt19937_64(state.thread_index());
+  auto distribution = std::uniform_int_distribution<uint64_t>(0, VALUE_COUNT - 1);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(read_value(distribution(random_generator)));
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetLabel(config_label());
+}
+
+// Reads 80% of the values from 20% of the pages (the first fifth of the data set), which fits into the memory budget.
+static void BM_SkewedRead(benchmark::State &state) {
+  auto random_generator = std::mt19937_64(state.thread_index());
+  auto hot = std::uniform_int_distribution<uint64_t>(0, VALUE_COUNT / 5 - 1);
+  auto all = std::uniform_int_distribution<uint64_t>(0, VALUE_COUNT - 1);
+  auto coin = std::uniform_int_distribution<uint32_t>(0, 9);
+  for (auto _ : state) {
+    const auto index = coin(random_generator) < 8 ? hot(random_generator) : all(random_generator);
+    benchmark::DoNotOptimize(read_value(index));
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetLabel(config_label());
+}
+
+// Reads uniformly distributed values of the pages that fit into half of the memory budget, thus (after warm-up) every
+// read takes the hit path.
+static void BM_HotRead(benchmark::State &state) {
+  auto random_generator = std::mt19937_64(state.thread_index());
+  auto distribution = std::uniform_int_distribution<uint64_t>(0, FRAME_COUNT / 2 * VALUES_PER_PAGE - 1);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(read_value(distribution(random_generator)));
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetLabel(config_label());
+}
+
+// Reads the metadata of every frame once per iteration, like the background writer and statistics do, without
+// accessing the pages.
+static void BM_FrameSweep(benchmark::State &state) {
+  auto &region = *buffer_manager->_volatile_region;
+  for (auto _ : state) {
+    uint64_t dirty_frames = 0;
+    for (uint64_t index = 0; index < region.frame_count(); ++index) {
+      auto *frame = region.frame_at(index);
+      dirty_frames += frame->page_id != INVALID_PAGE_ID && frame->is_dirty();
+    }
+    benchmark::DoNotOptimize(dirty_frames);
+  }
+  state.SetItemsProcessed(state.iterations() * region.frame_count());
+  state.SetLabel(config_label());
+}
+
+// Scans the whole data set once per iteration.
+static void BM_Scan(benchmark::State &state) {
+  for (auto _ : state) {
+    uint64_t sum = 0;
+    for (uint64_t index = 0; index < VALUE_COUNT; index += VALUES_PER_PAGE) {
+      sum += read_value(index);
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetBytesProcessed(state.iterations() * DATA_SET_SIZE);
+  state.SetLabel(config_label());
+}
+
+BENCHMARK(BM_RandomRead)->Threads(1)->Threads(4)->UseRealTime()->Setup(create_buffer_manager)
+    ->Teardown(destroy_buffer_manager);
+BENCHMARK(BM_SkewedRead)->Threads(1)->Threads(4)->UseRealTime()->Setup(create_buffer_manager)
+    ->Teardown(destroy_buffer_manager);
+BENCHMARK(BM_HotRead)->Threads(1)->Threads(4)->UseRealTime()->Setup(create_buffer_manager)
+    ->Teardown(destroy_buffer_manager);
+BENCHMARK(BM_FrameSweep)->UseRealTime()->Setup(create_buffer_manager)->Teardown(destroy_buffer_manager);
+BENCHMARK(BM_Scan)->UseRealTime()->Setup(create_buffer_manager)->Teardown(destroy_buffer_manager);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,157 @@
+#include <benchmark/benchmark.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <memory>
+#include <random>
+
+#include "data_regions.hpp"
+
+// Benchmarks of the volatile region's memory policies (see `MemoryPolicy`). BM_FirstTouch measures how long it takes
+// until every frame's page was touched once, including the construction of the region, i.e., the pre-faulting.
+// BM_SteadyState measures random reads of already touched pages. Both report the page faults per iteration,
+// BM_SteadyState also the data TLB misses per read if the system permits perf events. Arguments: huge pages (0: none, 1: transparent, 2: explicit),
+// pre-faulting threads, NUMA placement (0: default, 1: interleave, 2: partitioned).
+
+namespace {
+
+constexpr uint64_t FRAME_COUNT = 64 * 1024;
+constexpr uint64_t PARTITION_COUNT = 8;
+
+MemoryPolicy memory_policy(const benchmark::State &state) {
+  return {static_cast<MemoryPolicy::HugePages>(state.range(0)), static_cast<uint32_t>(state.range(1)),
+          static_cast<MemoryPolicy::NumaPlacement>(state.range(2)), {}};
+}
+
+uint64_t page_faults() {
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_minflt + usage.ru_majflt;
+}
+
+// Counts the data TLB misses of loads of the calling thread. Does nothing if perf events are not available.
+class TlbMissCounter {
+ public:
+  TlbMissCounter() {
+    perf_event_attr attributes{};
+    attributes.type = PERF_TYPE_HW_CACHE;
+    attributes.size = sizeof(attributes);
+    attributes.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                        (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attributes.disabled = 1;
+    attributes.exclude_kernel = 1;
+    _file = static_cast<int>(syscall(__NR_perf_event_open, &attributes, 0, -1, -1, 0));
+  }
+
+  ~TlbMissCounter() {
+    if (_file >= 0) {
+      close(_file);
+    }
+  }
+
+  bool available() const { return _file >= 0; }
+
+  void start() {
+    if (_file >= 0) {
+      ioctl(_file, PERF_EVENT_IOC_RESET, 0);
+      ioctl(_file, PERF_EVENT_IOC_ENABLE, 0);
+    }
+  }
+
+  uint64_t stop() {
+    uint64_t misses = 0;
+    if (_file >= 0) {
+      ioctl(_file, PERF_EVENT_IOC_DISABLE, 0);
+      if (read(_file, &misses, sizeof(misses)) != sizeof(misses)) {
+        misses = 0;
+      }
+    }
+    return misses;
+  }
+
+ private:
+  int _file = -1;
+};
+
+// Writes the first byte of every frame's page.
+void touch_all_frames(VolatileRegion &region) {
+  for (uint64_t index = 0; index < region.frame_count(); ++index) {
+    *reinterpret_cast<volatile std::byte *>(region.frame_at(index)->page.data()) = std::byte{1};
+  }
+}
+
+std::unique_ptr<VolatileRegion> region;
+
+void create_region(const benchmark::State &state) {
+  region = std::make_unique<VolatileRegion>(FRAME_COUNT, PARTITION_COUNT, memory_policy(state));
+  touch_all_frames(*region);
+}
+
+void destroy_region(const benchmark::State &) {
+  region.reset();
+}
+
+}  // namespace
+
+static void BM_FirstTouch(benchmark::State &state) {
+  const auto policy = memory_policy(state);
+  const auto faults_before = page_faults();
+  bool explicit_huge_pages = false;
+  for (auto _ : state) {
+    auto touched_region = std::make_unique<VolatileRegion>(FRAME_COUNT, PARTITION_COUNT, policy);
+    touch_all_frames(*touched_region);
+    explicit_huge_pages = touched_region->uses_explicit_huge_pages();
+    // Unmapping is not part of the measurement.
+    state.PauseTiming();
+    touched_region.reset();
+    state.ResumeTiming();
+  }
+  state.counters["page_faults"] = benchmark::Counter(static_cast<double>(page_faults() - faults_before),
+                                                     benchmark::Counter::kAvgIterations);
+  state.SetLabel(explicit_huge_pages ? "hugetlb" : "");
+  state.SetItemsProcessed(state.iterations() * FRAME_COUNT);
+}
+
+static void BM_SteadyState(benchmark::State &state) {
+  constexpr uint64_t reads_per_iteration = 1024;
+  auto random_generator = std::mt19937_64(42);
+  auto distribution = std::uniform_int_distribution<uint64_t>(0, FRAME_COUNT - 1);
+  auto tlb_misses = TlbMissCounter();
+  uint64_t misses = 0;
+  const auto faults_before = page_faults();
+  for (auto _ : state) {
+    uint64_t sum = 0;
+    tlb_misses.start();
+    for (uint64_t read = 0; read < reads_per_iteration; ++read) {
+      const auto frame = distribution(random_generator);
+      // Read from the middle of the page, so that interleaved frames do not only access the page next to the header.
+      sum += static_cast<uint64_t>(region->frame_at(frame)->page.data()[EFFECTIVE_PAGE_SIZE / 2]);
+    }
+    misses += tlb_misses.stop();
+    benchmark::DoNotOptimize(sum);
+  }
+  state.counters["page_faults"] = benchmark::Counter(static_cast<double>(page_faults() - faults_before),
+                                                     benchmark::Counter::kAvgIterations);
+  if (tlb_misses.available()) {
+    state.counters["dtlb_misses_per_read"] =
+        static_cast<double>(misses) / static_cast<double>(state.iterations() * reads_per_iteration);
+  }
+  state.SetLabel(region->uses_explicit_huge_pages() ? "hugetlb" : "");
+  state.SetItemsProcessed(state.iterations() * reads_per_iteration);
+}
+
+BENCHMARK(BM_FirstTouch)
+    ->ArgNames({"huge_pages", "prefault_threads", "numa"})
+    ->ArgsProduct({{0, 1, 2}, {0, 4}, {0, 1, 2}})
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_SteadyState)
+    ->ArgNames({"huge_pages", "prefault_threads", "numa"})
+    ->ArgsProduct({{0, 1, 2}, {0}, {0, 1, 2}})
+    ->Setup(create_region)
+    ->Teardown(destroy_region);
+
+BENCHMARK_MAIN();
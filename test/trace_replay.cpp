@@ -0,0 +1,172 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "access_trace.hpp"
+#include "buffer_manager.hpp"
+#include "memory_region.hpp"
+
+// Replays a page access trace (see `BufferManager::start_trace`) through the buffer manager with different pool sizes
+// and cooling shares. Pages are kept in memory (see `MemoryRegion`), thus the replay runs at full speed and shows the
+// buffer manager's decisions and CPU time only. All accesses are replayed by one thread in the order of the trace.
+//
+// Usage: trace_replay <trace> [pool sizes] [cooling shares]
+//
+// Pool sizes are given in percent of the distinct pages of each size class in the trace (default: 10,25,50,100), and
+// cooling shares as fractions of the frames (default: SHARE_COOLING_PAGES), both comma-separated. The cooling share
+// `adaptive` lets the buffer manager adapt the cooling stage, starting with SHARE_COOLING_PAGES (see
+// `CoolingStageConfig::adaptive`). Prints one line per configuration, including the final cooling target in frames.
+//
+// The trace does not record how pages reference each other, thus every page is replayed as a root page without
+// children. Pages that are accessed before they are allocated in the trace are allocated on their first access.
+
+namespace {
+
+// Every size class that occurs in the trace gets at least this number of frames.
+constexpr uint64_t MIN_FRAME_COUNT = 16;
+
+std::vector<std::string> parse_list(const char *argument) {
+  auto values = std::vector<std::string>{};
+  auto stream = std::istringstream(argument);
+  for (std::string value; std::getline(stream, value, ',');) {
+    values.push_back(value);
+  }
+  return values;
+}
+
+// Swips of the replayed pages and the mapping of the trace's page IDs to the IDs of the replayed pages.
+struct ReplayedPages : ManagedDataStructure {
+  std::unordered_map<PageID, Swip> swips;
+  std::unordered_map<PageID, PageID> page_ids;
+};
+
+// Returns the swip of the trace's page, allocating the page if the trace did not allocate it.
+Swip &swip_of(BufferManager &buffer_manager, ReplayedPages &pages, PageID page_id) {
+  if (auto page = pages.page_ids.find(page_id); page != pages.page_ids.end()) {
+    return pages.swips[page->second];
+  }
+  auto *frame = buffer_manager.allocate_page(page_size_class(page_id));
+  pages.page_ids[page_id] = frame->page_id;
+  return pages.swips[frame->page_id] = Swip(frame);
+}
+
+void replay(const std::vector<TraceRecord> &records, const std::array<uint64_t, PAGE_SIZE_CLASS_COUNT> &page_counts,
+            double pool_percent, const std::string &cooling_share) {
+  auto frame_counts = std::array<uint64_t, PAGE_SIZE_CLASS_COUNT>{};
+  uint64_t slot_count = 0;
+  for (uint64_t size_class = 0; size_class < PAGE_SIZE_CLASS_COUNT; ++size_class) {
+    if (page_counts[size_class] > 0) {
+      frame_counts[size_class] =
+          std::max(static_cast<uint64_t>(page_counts[size_class] * pool_percent / 100), MIN_FRAME_COUNT);
+      slot_count += page_counts[size_class] * page_slot_count(static_cast<PageSizeClass>(size_class));
+    }
+  }
+  // Pages of larger size classes are aligned to their size, which leaves gaps between them.
+  const auto ssd_page_count = 2 * slot_count + SSDRegion::FILE_EXTENT_PAGE_COUNT;
+  auto config = CoolingStageConfig{};
+  if (cooling_share == "adaptive") {
+    config.adaptive = true;
+  } else {
+    config.share_cooling_pages = std::stof(cooling_share);
+  }
+  auto buffer_manager = BufferManager(
+      std::make_unique<VolatileRegion>(frame_counts),
+      std::make_unique<MemoryRegion>(std::filesystem::temp_directory_path() / "trace_replay.ssd", ssd_page_count),
+      config);
+  auto pages = ReplayedPages{};
+  buffer_manager.register_data_structure(&pages);
+  buffer_manager.register_callbacks({nullptr, [](BufferFrame *frame, ManagedDataStructure *data_structure) -> Swip & {
+    return static_cast<ReplayedPages *>(data_structure)->swips[frame->page_id];
+  }});
+
+  const auto start = std::chrono::steady_clock::now();
+  for (const auto &record : records) {
+    switch (record.operation) {
+      case TraceOperation::GET:
+      case TraceOperation::SCAN: {
+        const auto mode = record.operation == TraceOperation::SCAN ? AccessMode::SCAN : AccessMode::NORMAL;
+        buffer_manager.get_frame(swip_of(buffer_manager, pages, record.page_id), mode);
+        break;
+      }
+      case TraceOperation::ALLOCATE: {
+        auto *frame = buffer_manager.allocate_page(page_size_class(record.page_id));
+        pages.page_ids[record.page_id] = frame->page_id;
+        pages.swips[frame->page_id] = Swip(frame);
+        break;
+      }
+      case TraceOperation::FREE: {
+        auto page = pages.page_ids.find(record.page_id);
+        if (page == pages.page_ids.end()) {
+          break;
+        }
+        // The page might have been evicted with this pool size.
+        auto *frame = buffer_manager.get_frame(pages.swips[page->second]);
+        buffer_manager.free_page(frame);
+        pages.swips.erase(page->second);
+        pages.page_ids.erase(page);
+        break;
+      }
+    }
+  }
+  const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  const auto statistics = buffer_manager.statistics();
+  uint64_t frame_count = 0;
+  for (auto count : frame_counts) {
+    frame_count += count;
+  }
+  std::printf("%8.1f %10lu %9s %8lu %12.3f %9.4f %12lu %12lu %12lu %14lu\n", pool_percent, frame_count,
+              cooling_share.c_str(), statistics.cooling_target, records.size() / seconds / 1e6, statistics.hit_rate(),
+              statistics.cooling_rescues, statistics.misses, statistics.evictions, statistics.sampling_iterations);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  if (argc < 2 || argc > 4) {
+    std::fprintf(stderr, "Usage: %s <trace> [pool sizes in percent] [cooling shares]\n", argv[0]);
+    return 1;
+  }
+  auto records = std::vector<TraceRecord>{};
+  if (!read_trace(argv[1], records)) {
+    std::fprintf(stderr, "Cannot read the trace %s\n", argv[1]);
+    return 1;
+  }
+  const auto pool_percents = argc > 2 ? parse_list(argv[2]) : std::vector<std::string>{"10", "25", "50", "100"};
+  const auto cooling_shares =
+      argc > 3 ? parse_list(argv[3]) : std::vector<std::string>{std::to_string(SHARE_COOLING_PAGES)};
+
+  // Distinct pages per size class, and the share of accesses that found their page in memory while recording.
+  auto page_ids = std::unordered_set<PageID>{};
+  auto page_counts = std::array<uint64_t, PAGE_SIZE_CLASS_COUNT>{};
+  uint64_t accesses = 0;
+  uint64_t recorded_hits = 0;
+  for (const auto &record : records) {
+    if (page_ids.insert(record.page_id).second) {
+      ++page_counts[static_cast<uint64_t>(page_size_class(record.page_id))];
+    }
+    if (record.operation == TraceOperation::GET || record.operation == TraceOperation::SCAN) {
+      ++accesses;
+      recorded_hits += record.state != TraceState::EVICTED;
+    }
+  }
+  std::printf("%lu records, %lu accesses of %lu pages, recorded hit rate %.4f\n", records.size(), accesses,
+              page_ids.size(), accesses ? static_cast<double>(recorded_hits) / accesses : 0);
+
+  std::printf("%8s %10s %9s %8s %12s %9s %12s %12s %12s %14s\n", "pool%", "frames", "cooling", "target",
+              "Mrecords/s", "hit_rate", "rescues", "misses", "evictions", "sampling_iter");
+  for (auto pool_percent : pool_percents) {
+    for (auto share : cooling_shares) {
+      replay(records, page_counts, std::stod(pool_percent), share);
+    }
+  }
+  return 0;
+}